@@ -0,0 +1,278 @@
+// VariantKey FASTA to genoref binary converter
+//
+// fastabin.c
+//
+// @category   Tools
+// @author     Nicola Asuni <info@tecnick.com>
+// @link       https://github.com/tecnickcom/variantkey
+// @license    MIT [LICENSE](https://raw.githubusercontent.com/tecnickcom/variantkey/main/LICENSE)
+
+// Create the binary genome reference file used by genoref.h from a FASTA file.
+// The sequences are mapped to chromosomes 1 to 22, X, Y and MT by name (see encode_chrom),
+// all other sequences are ignored.
+// The input file is memory mapped and each chromosome is processed by a separate thread.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../src/variantkey/genoref.h"
+
+#ifndef VERSION
+#define VERSION "0.0.0-0"
+#endif
+
+#define NCHROM 25              //!< Number of supported chromosomes.
+#define HEADER_SIZE 248        //!< Size of the genoref file header.
+#define COPY_BUFSIZE (1 << 20) //!< Size of the copy buffer of each thread.
+
+typedef struct contig_t
+{
+    const uint8_t *start; //!< Pointer to the first byte of the sequence.
+    const uint8_t *end;   //!< Pointer to the end of the sequence.
+    uint64_t nbases;      //!< Number of bases.
+    uint64_t offset;      //!< Offset of the sequence in the output file.
+    int fd;               //!< Output file descriptor.
+    int err;              //!< Error code.
+} contig_t;
+
+// find the sequence of each chromosome
+static void find_contigs(const uint8_t *src, uint64_t size, contig_t *contig)
+{
+    const uint8_t *p = src;
+    const uint8_t *end = (src + size);
+    const uint8_t *eol = NULL;
+    const uint8_t *name = NULL;
+    contig_t *cur = NULL;
+    uint8_t chrom = 0;
+    while (p < end)
+    {
+        eol = (const uint8_t *)memchr(p, '\n', (size_t)(end - p));
+        eol = (eol == NULL) ? end : eol;
+        if (*p == '>')
+        {
+            if (cur != NULL)
+            {
+                cur->end = p;
+            }
+            name = ++p;
+            while ((p < eol) && (*p != ' ') && (*p != '\t') && (*p != '\r'))
+            {
+                p++;
+            }
+            chrom = encode_chrom((const char *)name, (size_t)(p - name));
+            cur = NULL;
+            if ((chrom > 0) && (chrom <= NCHROM))
+            {
+                if (contig[(chrom - 1)].start == NULL)
+                {
+                    cur = &contig[(chrom - 1)];
+                    cur->start = (eol < end) ? (eol + 1) : end;
+                    cur->end = end;
+                }
+                else
+                {
+                    (void) fprintf(stderr, "WARNING: ignoring duplicate sequence %.*s\n", (int)(p - name), (const char *)name);
+                }
+            }
+        }
+        p = (eol + 1);
+    }
+}
+
+// count the bases of a sequence, excluding line terminators
+static void *count_bases(void *arg)
+{
+    contig_t *c = (contig_t *)arg;
+    const uint8_t *p = NULL;
+    uint64_t n = 0;
+    for (p = c->start; p < c->end; p++)
+    {
+        n += ((*p != '\n') && (*p != '\r'));
+    }
+    c->nbases = n;
+    return NULL;
+}
+
+// copy the bases of a sequence to the output file, excluding line terminators
+static void *copy_bases(void *arg)
+{
+    contig_t *c = (contig_t *)arg;
+    uint8_t *buf = (uint8_t *)malloc(COPY_BUFSIZE);
+    const uint8_t *p = c->start;
+    uint64_t offset = c->offset;
+    size_t n = 0;
+    if (buf == NULL)
+    {
+        c->err = 1;
+        return NULL;
+    }
+    while ((p < c->end) || (n > 0))
+    {
+        if ((p < c->end) && (n < COPY_BUFSIZE))
+        {
+            buf[n] = *p;
+            n += ((*p != '\n') && (*p != '\r'));
+            p++;
+            continue;
+        }
+        if (pwrite(c->fd, buf, n, (off_t)offset) != (ssize_t)n)
+        {
+            c->err = 1;
+            break;
+        }
+        offset += n;
+        n = 0;
+    }
+    free(buf);
+    return NULL;
+}
+
+// run the specified function on each chromosome in parallel
+static void run_contigs(contig_t *contig, void *(*fn)(void *))
+{
+    pthread_t tid[NCHROM];
+    int started[NCHROM] = {0};
+    int i = 0;
+    for (i = 0; i < NCHROM; i++)
+    {
+        if (contig[i].start == NULL)
+        {
+            continue;
+        }
+        started[i] = (pthread_create(&tid[i], NULL, fn, &contig[i]) == 0);
+        if (!started[i])
+        {
+            (void) fn(&contig[i]);
+        }
+    }
+    for (i = 0; i < NCHROM; i++)
+    {
+        if (started[i])
+        {
+            (void) pthread_join(tid[i], NULL);
+        }
+    }
+}
+
+// write the genoref file in the original format
+static int write_genoref(contig_t *contig, const char *file)
+{
+    uint8_t header[HEADER_SIZE] = {0};
+    uint64_t offset = HEADER_SIZE;
+    uint64_t nrows = 1;
+    int i = 0, err = 0;
+    memcpy(header, "BINSRC1", 8);
+    header[8] = NCHROM;
+    memset((header + 9), 1, NCHROM); // 1 byte per column
+    memcpy((header + 40), &nrows, 8);
+    for (i = 0; i < NCHROM; i++)
+    {
+        contig[i].offset = offset;
+        memcpy((header + 48 + (i * 8)), &offset, 8);
+        offset += contig[i].nbases;
+    }
+    int fd = open(file, (O_WRONLY | O_CREAT | O_TRUNC), 0644);
+    if (fd < 0)
+    {
+        return 1;
+    }
+    err = (pwrite(fd, header, HEADER_SIZE, 0) != HEADER_SIZE);
+    for (i = 0; i < NCHROM; i++)
+    {
+        contig[i].fd = fd;
+    }
+    if (err == 0)
+    {
+        run_contigs(contig, copy_bases);
+        for (i = 0; i < NCHROM; i++)
+        {
+            err |= contig[i].err;
+        }
+    }
+    return ((close(fd) != 0) || (err != 0));
+}
+
+// write the packed genoref file from the original one
+static int write_packed_genoref(const char *srcfile, const char *file)
+{
+    mmfile_t mf = {0};
+    uint64_t nexc = 0, nlow = 0;
+    mmap_genoref_file(srcfile, &mf);
+    if ((mf.fd < 0) || (mf.size < HEADER_SIZE))
+    {
+        return 1;
+    }
+    pack_genoref(mf, NULL, NULL, NULL, NULL, NULL, NULL, &nexc, &nlow);
+    uint64_t nbases = (mf.index[26] - mf.index[1]);
+    uint8_t *packed = (uint8_t *)malloc((size_t)((nbases + 3) / 4) + 1);
+    uint64_t *excstart = (uint64_t *)malloc((size_t)((nexc + 1) * 8));
+    uint64_t *excend = (uint64_t *)malloc((size_t)((nexc + 1) * 8));
+    uint8_t *excchar = (uint8_t *)malloc((size_t)(nexc + 1));
+    uint64_t *lowstart = (uint64_t *)malloc((size_t)((nlow + 1) * 8));
+    uint64_t *lowend = (uint64_t *)malloc((size_t)((nlow + 1) * 8));
+    int err = ((packed == NULL) || (excstart == NULL) || (excend == NULL) || (excchar == NULL) || (lowstart == NULL) || (lowend == NULL));
+    if (err == 0)
+    {
+        err = (write_genoref_packed_file(mf, file, packed, excstart, excend, excchar, lowstart, lowend) == 0);
+    }
+    free(packed);
+    free(excstart);
+    free(excend);
+    free(excchar);
+    free(lowstart);
+    free(lowend);
+    return ((munmap_binfile(mf) != 0) || (err != 0));
+}
+
+int main(int argc, char *argv[])
+{
+    contig_t contig[NCHROM];
+    struct stat statbuf;
+    int packed = ((argc == 4) && (strcmp(argv[1], "-p") == 0));
+    if (argc != (3 + packed))
+    {
+        (void) fprintf(stderr, "VariantKey FASTA to genoref binary converter %s\nUsage: fastabin [-p] INPUT.fa OUTPUT.bin\n  -p : write the packed 2-bit format\n", VERSION);
+        return 1;
+    }
+    const char *infile = argv[(1 + packed)];
+    const char *outfile = argv[(2 + packed)];
+    int fd = open(infile, O_RDONLY);
+    if ((fd < 0) || (fstat(fd, &statbuf) < 0) || (statbuf.st_size == 0))
+    {
+        (void) fprintf(stderr, "ERROR: unable to read %s\n", infile);
+        return 1;
+    }
+    const uint8_t *src = (const uint8_t *)mmap(0, (size_t)statbuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (src == MAP_FAILED)
+    {
+        (void) fprintf(stderr, "ERROR: unable to map %s\n", infile);
+        return 1;
+    }
+    memset(contig, 0, sizeof(contig));
+    find_contigs(src, (uint64_t)statbuf.st_size, contig);
+    run_contigs(contig, count_bases);
+    char tmpfile[4096];
+    (void) snprintf(tmpfile, sizeof(tmpfile), "%s.tmp", outfile);
+    int err = write_genoref(contig, (packed ? tmpfile : outfile));
+    (void) munmap((void *)src, (size_t)statbuf.st_size);
+    (void) close(fd);
+    if ((err == 0) && packed)
+    {
+        err = write_packed_genoref(tmpfile, outfile);
+        (void) unlink(tmpfile);
+    }
+    if (err != 0)
+    {
+        (void) fprintf(stderr, "ERROR: unable to write %s\n", outfile);
+        return 1;
+    }
+    return 0;
+}
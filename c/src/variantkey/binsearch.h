@@ -45,6 +45,7 @@
 #include <fcntl.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <unistd.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
@@ -1041,4 +1042,54 @@ static inline int munmap_binfile(mmfile_t mf)
     return close(mf.fd);
 }
 
+/**
+ * Write a set of columns to a file in the "BINSRC1" format.
+ * The columns are written in the specified order, each one padded to 8 bytes.
+ *
+ * @param file     Output file name. NOTE: existing files will be replaced.
+ * @param nrows    Number of rows.
+ * @param ncols    Number of columns.
+ * @param ctbytes  Number of bytes per column type (i.e. 1 for uint8_t, 2 for uint16_t, 4 for uint32_t, 8 for uint64_t).
+ * @param cols     Pointers to the columns data.
+ * @param colsize  Size in bytes of each column data (usually nrows * ctbytes).
+ *
+ * @return Number of written bytes or 0 in case of error.
+ */
+static inline size_t write_binsrc1_file(const char *file, uint64_t nrows, uint8_t ncols, const uint8_t *ctbytes, const void *const *cols, const uint64_t *colsize)
+{
+    static const uint8_t pad[8] = {0};
+    uint64_t offset[MAXCOLS];
+    uint64_t hlen = (uint64_t)9 + ncols + ((8 - ((ncols + 1) & 7)) & 7); // account for 8-byte padding
+    uint64_t pos = hlen + ((uint64_t)(ncols + 1) * 8);
+    uint64_t plen = 0;
+    uint8_t i = 0;
+    for (i = 0; i < ncols; i++)
+    {
+        offset[i] = pos;
+        pos += colsize[i] + ((8 - (colsize[i] & 7)) & 7);
+    }
+    FILE *fp = fopen(file, "we");
+    if (fp == NULL)
+    {
+        return 0;
+    }
+    int err = ((fwrite("BINSRC1", 1, 8, fp) != 8)
+               || (fwrite(&ncols, 1, 1, fp) != 1)
+               || (fwrite(ctbytes, 1, ncols, fp) != ncols)
+               || (fwrite(pad, 1, (size_t)(hlen - 9 - ncols), fp) != (size_t)(hlen - 9 - ncols))
+               || (fwrite(&nrows, 8, 1, fp) != 1)
+               || (fwrite(offset, 8, ncols, fp) != ncols));
+    for (i = 0; (i < ncols) && (err == 0); i++)
+    {
+        plen = ((8 - (colsize[i] & 7)) & 7);
+        err = ((fwrite(cols[i], 1, (size_t)colsize[i], fp) != (size_t)colsize[i])
+               || (fwrite(pad, 1, (size_t)plen, fp) != (size_t)plen));
+    }
+    if ((fclose(fp) != 0) || (err != 0))
+    {
+        return 0;
+    }
+    return (size_t)pos;
+}
+
 #endif  // VARIANTKEY_BINSEARCH_H
@@ -21,12 +21,17 @@
 #include <stdint.h>
 #include <stdio.h>
 
-#define ESID_MAXLEN   10 //!< Maximum number of characters that can be encoded
-#define ESID_SHIFT    32 //!< Number used to translate ASCII character values
-#define ESID_SHIFTPOS 60 //!< Encoded string ID LEN LSB position from LSB [ ----0000 00111111 22222233 33334444 44555555 66666677 77778888 88999999 ]
-#define ESID_CHARBIT  6  //!< Number of bit used to encode a char
-#define ESID_NUMPOS   27 //!< Number of bit used to encode a number in the srting_num encoding
-#define ESID_MAXPAD   7  //!< Max number of padding zero digits
+#define ESID_MAXLEN     10                 //!< Maximum number of characters that can be encoded
+#define ESID_SHIFT      32                 //!< Number used to translate ASCII character values
+#define ESID_SHIFTPOS   60                 //!< Encoded string ID LEN LSB position from LSB [ ----0000 00111111 22222233 33334444 44555555 66666677 77778888 88999999 ]
+#define ESID_CHARBIT    6                  //!< Number of bit used to encode a char
+#define ESID_NUMPOS     27                 //!< Number of bit used to encode a number in the srting_num encoding
+#define ESID_MAXPAD     7                  //!< Max number of padding zero digits
+#define ESID_MAXDECLEN  23                 //!< Maximum size of a decoded string ID, including the terminating null byte
+#define ESID_ONES       0x0101010101010101 //!< 8 bytes with value 1, used for SWAR (SIMD within a register) byte operations
+#define ESID_HIGHS      0x8080808080808080 //!< 8 bytes with the most significant bit set
+#define ESID_HASH_LANES 4                  //!< Number of strings hashed at once by hash_string_id_array
+#define ESID_HASH_MINWORDS 8               //!< Minimum average number of 8 byte words per string to interleave the hash chains
 
 /**
  * Encode a single character into a 64 bit unsigned integer.
@@ -120,6 +125,97 @@ static inline uint64_t encode_string_id(const char *str, size_t size, size_t sta
     return h;
 }
 
+/**
+ * Load 8 bytes as a little-endian 64 bit unsigned integer, independently of the platform endianness and alignment.
+ *
+ * @param p  Pointer to the first byte.
+ *
+ * @return Loaded value.
+ */
+static inline uint64_t esid_load_u64le(const uint8_t *p)
+{
+    return ((uint64_t)p[0] | ((uint64_t)p[1] << 8) | ((uint64_t)p[2] << 16) | ((uint64_t)p[3] << 24)
+            | ((uint64_t)p[4] << 32) | ((uint64_t)p[5] << 40) | ((uint64_t)p[6] << 48) | ((uint64_t)p[7] << 56));
+}
+
+/**
+ * Store a 64 bit unsigned integer as 8 little-endian bytes, independently of the platform endianness and alignment.
+ *
+ * @param p  Pointer to the first output byte.
+ * @param w  Value to store.
+ */
+static inline void esid_store_u64le(uint8_t *p, uint64_t w)
+{
+    p[0] = (uint8_t)w;
+    p[1] = (uint8_t)(w >> 8);
+    p[2] = (uint8_t)(w >> 16);
+    p[3] = (uint8_t)(w >> 24);
+    p[4] = (uint8_t)(w >> 32);
+    p[5] = (uint8_t)(w >> 40);
+    p[6] = (uint8_t)(w >> 48);
+    p[7] = (uint8_t)(w >> 56);
+}
+
+/**
+ * Load up to 8 bytes as a little-endian 64 bit unsigned integer, setting the missing bytes to zero.
+ *
+ * @param p     Pointer to the first byte.
+ * @param size  Number of bytes to load.
+ *
+ * @return Loaded value.
+ */
+static inline uint64_t esid_load_u64le_partial(const uint8_t *p, size_t size)
+{
+    if (size >= 8)
+    {
+        return esid_load_u64le(p);
+    }
+    uint64_t w = 0;
+    while (size > 0)
+    {
+        --size;
+        w |= ((uint64_t)p[size] << (8 * size));
+    }
+    return w;
+}
+
+/**
+ * Encode up to 8 ASCII characters at once (SWAR) in the same way as esid_encode_char.
+ * The 6 bit codes are packed with the first character in the most significant position.
+ *
+ * @param w     Little-endian word containing the characters. No byte can have the most significant bit set.
+ * @param size  Number of valid characters in the word (maximum 8).
+ *
+ * @return Packed 48 bit code.
+ */
+static inline uint64_t esid_encode_word(uint64_t w, size_t size)
+{
+    uint64_t valid = (size >= 8) ? 0xffffffffffffffff : (((uint64_t)1 << (8 * size)) - 1);
+    uint64_t m = (((w + (ESID_ONES * (0x80 - '!'))) & ESID_HIGHS) >> 7) * 0xff; // bytes >= '!'
+    w = ((w & m) | ((ESID_ONES * '_') & ~m)); // map the bytes < '!' to '_'
+    uint64_t gt = ((w + (ESID_ONES * (0x80 - '`'))) & ESID_HIGHS); // bytes > '_'
+    w = ((w - ((ESID_ONES * ESID_SHIFT) + (gt >> 2))) & valid);
+    // pack the 6 bit codes in 12, 24 and 48 bit groups
+    w = (((w & 0x00ff00ff00ff00ff) << ESID_CHARBIT) | ((w >> 8) & 0x00ff00ff00ff00ff));
+    w = (((w & 0x0000ffff0000ffff) << (ESID_CHARBIT * 2)) | ((w >> 16) & 0x0000ffff0000ffff));
+    return (((w & 0xffffffff) << (ESID_CHARBIT * 4)) | (w >> 32));
+}
+
+/**
+ * Decode 8 characters at once (SWAR) from the 48 bit code returned by esid_encode_word.
+ *
+ * @param h  Packed 48 bit code.
+ *
+ * @return Little-endian word containing the decoded characters.
+ */
+static inline uint64_t esid_decode_word(uint64_t h)
+{
+    uint64_t w = ((h >> (ESID_CHARBIT * 4)) | ((h & 0xffffff) << 32));
+    w = (((w >> (ESID_CHARBIT * 2)) & 0x00000fff00000fff) | ((w & 0x00000fff00000fff) << 16));
+    w = (((w >> ESID_CHARBIT) & 0x003f003f003f003f) | ((w & 0x003f003f003f003f) << 8));
+    return (w + (ESID_ONES * ESID_SHIFT));
+}
+
 /**
  * Encode a string composed by a character section followed by a separator character and a numerical section
  * into a 64 bit unsigned integer. For example: "ABCDE:0001234".
@@ -272,6 +368,108 @@ static inline size_t decode_string_id(uint64_t esid, char *str)
     return esid_decode_string_id(size, esid, str);
 }
 
+/**
+ * Encode an array of strings in the same way as encode_string_id(str, size, 0).
+ * The strings are stored contiguously in the data buffer and delimited by an offset array (as in Apache Arrow):
+ * the string i starts at data[offset[i]] and ends at data[offset[i+1]].
+ * Up to 8 characters are processed at once (SWAR).
+ *
+ * @param data    Buffer containing the strings.
+ * @param offset  Array of nitems + 1 string offsets.
+ * @param nitems  Number of strings.
+ * @param esid    Output array of encoded string IDs (it must be sized nitems items at least).
+ */
+static inline void encode_string_id_array(const char *data, const uint64_t *offset, uint64_t nitems, uint64_t *esid)
+{
+    const uint8_t *str = NULL;
+    uint64_t i = 0, w = 0, h = 0;
+    size_t size = 0, n = 0;
+    for (i = 0; i < nitems; i++)
+    {
+        str = (const uint8_t *)(data + offset[i]);
+        size = (size_t)(offset[(i + 1)] - offset[i]);
+        if (size > ESID_MAXLEN)
+        {
+            size = ESID_MAXLEN;
+        }
+        n = (size > 8) ? 8 : size;
+        w = esid_load_u64le_partial(str, n);
+        if ((w & ESID_HIGHS) != 0)
+        {
+            esid[i] = encode_string_id((const char *)str, size, 0);
+            continue;
+        }
+        h = (((uint64_t)size << ESID_SHIFTPOS) | (esid_encode_word(w, n) << (ESID_CHARBIT * 2)));
+        switch (size)
+        {
+        case 10:
+            h |= esid_encode_char((char)str[9]);
+        // fall through
+        case 9:
+            h |= (esid_encode_char((char)str[8]) << ESID_CHARBIT);
+        // fall through
+        default:
+            break;
+        }
+        esid[i] = h;
+    }
+}
+
+/**
+ * Decode an array of encoded string IDs in the same way as decode_string_id.
+ * The decoded strings are stored contiguously (without the terminating null byte) in the data buffer,
+ * the string i starts at data[offset[i]] and ends at data[offset[i+1]].
+ * Up to 8 characters are processed at once (SWAR).
+ *
+ * @param esid    Array of encoded string IDs.
+ * @param nitems  Number of items.
+ * @param data    Output buffer for the strings (it must be sized nitems * ESID_MAXDECLEN bytes at least).
+ * @param offset  Output array of string offsets (it must be sized nitems + 1 items at least).
+ *
+ * @return Total number of characters stored in the data buffer.
+ */
+static inline uint64_t decode_string_id_array(const uint64_t *esid, uint64_t nitems, char *data, uint64_t *offset)
+{
+    uint8_t *str = NULL;
+    uint64_t i = 0, w = 0, pos = 0;
+    size_t size = 0, k = 0;
+    for (i = 0; i < nitems; i++)
+    {
+        offset[i] = pos;
+        size = (size_t)(esid[i] >> ESID_SHIFTPOS);
+        if (size > ESID_MAXLEN)
+        {
+            pos += esid_decode_string_num_id((size - ESID_MAXLEN), esid[i], (data + pos));
+            continue;
+        }
+        str = (uint8_t *)(data + pos);
+        w = esid_decode_word((esid[i] >> (ESID_CHARBIT * 2)) & 0xffffffffffff);
+        pos += size;
+        if (size < 8)
+        {
+            for (k = 0; k < size; k++)
+            {
+                str[k] = (uint8_t)(w >> (8 * k));
+            }
+            continue;
+        }
+        esid_store_u64le(str, w);
+        switch (size)
+        {
+        case 10:
+            str[9] = (uint8_t)esid_decode_char(esid[i], 0);
+        // fall through
+        case 9:
+            str[8] = (uint8_t)esid_decode_char(esid[i], ESID_CHARBIT);
+        // fall through
+        default:
+            break;
+        }
+    }
+    offset[nitems] = pos;
+    return pos;
+}
+
 /**
  * Mix two 64 bit hash numbers using a MurmurHash3-like algorithm.
  * This function is used to combine hash values in a way that
@@ -293,51 +491,24 @@ static inline uint64_t muxhash64(uint64_t k, uint64_t h)
 }
 
 /**
- * Hash the input string into a 64 bit unsigned integer.
- * This function can be used to convert long string IDs into non-reversible numeric IDs.
+ * Hash the remaining bytes of a string and apply the final mix.
+ * This is the common part of hash_string_id and hash_string_id_array.
  *
- * @param str    The string to encode.
- * @param size   Length of the string, excluding the terminating null byte.
+ * @param pos    Pointer to the first byte to hash.
+ * @param size   Number of bytes to hash.
+ * @param h      Hash value of the preceding bytes (0 at the start of the string).
  *
  * @return Hash string ID.
  */
-static inline uint64_t hash_string_id(const char *str, size_t size)
+static inline uint64_t esid_hash_final(const uint8_t *pos, size_t size, uint64_t h)
 {
-    const uint64_t *pos = (const uint64_t *)str; // NOTE endianness
-    const uint64_t *end = pos + (size / 8);
-    uint64_t h = 0;
+    const uint8_t *end = pos + (size & ~(size_t)7);
     while (pos < end)
     {
-        h = muxhash64(*pos++, h);
-    }
-    const uint8_t *tail = (const uint8_t *)pos;
-    uint64_t v = 0;
-    switch (size & 7)
-    {
-    case 7:
-        v ^= (uint64_t)tail[6] << (8 * 6);
-    // fall through
-    case 6:
-        v ^= (uint64_t)tail[5] << (8 * 5);
-    // fall through
-    case 5:
-        v ^= (uint64_t)tail[4] << (8 * 4);
-    // fall through
-    case 4:
-        v ^= (uint64_t)tail[3] << (8 * 3);
-    // fall through
-    case 3:
-        v ^= (uint64_t)tail[2] << (8 * 2);
-    // fall through
-    case 2:
-        v ^= (uint64_t)tail[1] << (8 * 1);
-    // fall through
-    case 1:
-        v ^= (uint64_t)tail[0];
-        break;
-    default:
-        break;
+        h = muxhash64(esid_load_u64le(pos), h);
+        pos += 8;
     }
+    uint64_t v = esid_load_u64le_partial(pos, (size & 7));
     if (v > 0)
     {
         h = muxhash64(v, h);
@@ -351,4 +522,76 @@ static inline uint64_t hash_string_id(const char *str, size_t size)
     return (h | 0x8000000000000000); // set the first bit to indicate HASH mode
 }
 
+/**
+ * Hash the input string into a 64 bit unsigned integer.
+ * This function can be used to convert long string IDs into non-reversible numeric IDs.
+ * The string is read in 8 byte little-endian words, so the result does not depend on the platform.
+ *
+ * @param str    The string to encode.
+ * @param size   Length of the string, excluding the terminating null byte.
+ *
+ * @return Hash string ID.
+ */
+static inline uint64_t hash_string_id(const char *str, size_t size)
+{
+    return esid_hash_final((const uint8_t *)str, size, 0);
+}
+
+/**
+ * Hash an array of strings in the same way as hash_string_id.
+ * The strings are stored contiguously in the data buffer and delimited by an offset array (as in Apache Arrow):
+ * the string i starts at data[offset[i]] and ends at data[offset[i+1]].
+ * Long strings are hashed ESID_HASH_LANES at a time with independent interleaved hash chains,
+ * so the CPU can overlap the multiplications of different strings.
+ *
+ * @param data    Buffer containing the strings.
+ * @param offset  Array of nitems + 1 string offsets.
+ * @param nitems  Number of strings.
+ * @param hsid    Output array of hash string IDs (it must be sized nitems items at least).
+ */
+static inline void hash_string_id_array(const char *data, const uint64_t *offset, uint64_t nitems, uint64_t *hsid)
+{
+    const uint8_t *pos[ESID_HASH_LANES];
+    size_t size[ESID_HASH_LANES];
+    uint64_t h[ESID_HASH_LANES];
+    uint64_t i = 0;
+    size_t j = 0, k = 0, nw = 0;
+    for (i = 0; (i + ESID_HASH_LANES) <= nitems; i += ESID_HASH_LANES)
+    {
+        if ((offset[(i + ESID_HASH_LANES)] - offset[i]) < (ESID_HASH_LANES * ESID_HASH_MINWORDS * 8))
+        {
+            // short strings are already overlapped by the CPU out-of-order execution
+            for (k = 0; k < ESID_HASH_LANES; k++)
+            {
+                hsid[(i + k)] = hash_string_id((data + offset[(i + k)]), (size_t)(offset[(i + k + 1)] - offset[(i + k)]));
+            }
+            continue;
+        }
+        nw = SIZE_MAX;
+        for (k = 0; k < ESID_HASH_LANES; k++)
+        {
+            pos[k] = (const uint8_t *)(data + offset[(i + k)]);
+            size[k] = (size_t)(offset[(i + k + 1)] - offset[(i + k)]);
+            h[k] = 0;
+            nw = ((size[k] / 8) < nw) ? (size[k] / 8) : nw;
+        }
+        // words shared by all the lanes
+        for (j = 0; j < (nw * 8); j += 8)
+        {
+            for (k = 0; k < ESID_HASH_LANES; k++)
+            {
+                h[k] = muxhash64(esid_load_u64le(pos[k] + j), h[k]);
+            }
+        }
+        for (k = 0; k < ESID_HASH_LANES; k++)
+        {
+            hsid[(i + k)] = esid_hash_final((pos[k] + (nw * 8)), (size[k] - (nw * 8)), h[k]);
+        }
+    }
+    for (; i < nitems; i++)
+    {
+        hsid[i] = hash_string_id((data + offset[i]), (size_t)(offset[(i + 1)] - offset[i]));
+    }
+}
+
 #endif  // VARIANTKEY_ESID_H
@@ -0,0 +1,354 @@
+// VariantKey
+//
+// esiddict.h
+//
+// @category   Libraries
+// @author     Nicola Asuni <info@tecnick.com>
+// @link       https://github.com/tecnickcom/variantkey
+// @license    MIT [LICENSE](https://raw.githubusercontent.com/tecnickcom/variantkey/main/LICENSE)
+
+/**
+ * @file esiddict.h
+ * @brief Functions to retrieve the original string IDs by ESID from a binary dictionary file.
+ *
+ * The functions provided here allows to retrieve the original string ID
+ * for a given encoded (encode_string_id) or hashed (hash_string_id) string ID code.
+ * Hashed string IDs are not reversible, so the dictionary is the only way to decode them.
+ *
+ * The lookup can use a binary search on the sorted ESID column
+ * or the optional minimal perfect hash index (hash and displace, as in PTHash),
+ * that finds a row in constant time with a couple of memory accesses.
+ *
+ * esiddict.bin:
+ * Dictionary of string IDs.
+ * This binary file can be generated by the `build_esiddict`, `build_esiddict_mph` and `write_esiddict_file` functions
+ * and has the following "BINSRC1" format:
+ *
+ *     BINSRC1 00
+ *     05 08 08 01 04 04 00 00
+ *     [8 BYTE NUMBER OF ROWS]
+ *     [8 BYTE COLUMN OFFSET]+
+ *     [8 BYTE ESID COLUMN SORTED IN ASCENDING ORDER]+
+ *     [8 BYTE STRING OFFSET]+ (number of rows + 1)
+ *     [STRING DATA]+
+ *     [4 BYTE MPH BUCKET DISPLACEMENT]+ (optional)
+ *     [4 BYTE MPH ROW]+ (optional)
+ *
+ * The last two columns are not present (3 columns format) when the file is generated without the hash index.
+ */
+
+#ifndef VARIANTKEY_ESIDDICT_H
+#define VARIANTKEY_ESIDDICT_H
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <string.h>
+#include "binsearch.h"
+#include "esid.h"
+#include "set.h"
+
+#define ESIDDICT_MPH_LAMBDA 4       //!< Average number of keys per minimal perfect hash bucket.
+#define ESIDDICT_NOROW 0xffffffff   //!< Marker of the free slots while building the minimal perfect hash.
+
+/**
+ * Struct containing the ESID dictionary memory mapped file column info.
+ */
+typedef struct esiddict_cols_t
+{
+    const uint64_t *esid;    //!< Pointer to the ESID column (sorted in ascending order).
+    const uint64_t *offset;  //!< Pointer to the string offset column (nrows + 1 items).
+    const char     *data;    //!< Pointer to the string data column.
+    const uint32_t *disp;    //!< Pointer to the MPH bucket displacement column (NULL if not available).
+    const uint32_t *row;     //!< Pointer to the MPH row column (NULL if not available).
+    uint64_t nrows;          //!< Number of rows.
+    uint64_t nbuckets;       //!< Number of MPH buckets.
+} esiddict_cols_t;
+
+/**
+ * Returns the number of minimal perfect hash buckets for the specified number of rows.
+ *
+ * @param nrows  Number of rows.
+ *
+ * @return Number of buckets.
+ */
+static inline uint64_t get_esiddict_mph_nbuckets(uint64_t nrows)
+{
+    return ((nrows + ESIDDICT_MPH_LAMBDA - 1) / ESIDDICT_MPH_LAMBDA);
+}
+
+/**
+ * Mix the bits of a 64 bit value (MurmurHash3 finalization mix).
+ *
+ * @param k  Value to mix.
+ *
+ * @return Mixed value.
+ */
+static inline uint64_t esiddict_mix(uint64_t k)
+{
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccd;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53;
+    k ^= k >> 33;
+    return k;
+}
+
+/**
+ * Returns the minimal perfect hash bucket of a mixed ESID (from the 32 most significant bits).
+ *
+ * @param h         Mixed ESID (esiddict_mix).
+ * @param nbuckets  Number of buckets.
+ *
+ * @return Bucket number.
+ */
+static inline uint64_t esiddict_mph_bucket(uint64_t h, uint64_t nbuckets)
+{
+    return (((h >> 32) * nbuckets) >> 32);
+}
+
+/**
+ * Returns the minimal perfect hash slot of a mixed ESID (from the 32 least significant bits).
+ *
+ * @param h      Mixed ESID (esiddict_mix).
+ * @param disp   Displacement of the ESID bucket.
+ * @param nrows  Number of rows (less than 2^32).
+ *
+ * @return Slot number.
+ */
+static inline uint64_t esiddict_mph_slot(uint64_t h, uint32_t disp, uint64_t nrows)
+{
+    return ((((h ^ esiddict_mix((uint64_t)disp + 1)) & 0xffffffff) * nrows) >> 32);
+}
+
+/**
+ * Build the sorted dictionary columns from an array of strings and the corresponding ESID codes.
+ * The input strings are stored contiguously in the data buffer and delimited by an offset array (as in Apache Arrow):
+ * the string i starts at data[offset[i]] and ends at data[offset[i+1]].
+ *
+ * @param esid       Array of ESID codes (encode_string_id or hash_string_id), one for each string.
+ *                   It will be sorted in ascending order.
+ * @param tmp        Temporary array (it must be sized nitems items at least).
+ * @param idx        Temporary index array (it must be sized nitems items at least).
+ * @param tdx        Temporary index array (it must be sized nitems items at least).
+ * @param data       Buffer containing the strings.
+ * @param offset     Array of nitems + 1 string offsets.
+ * @param nitems     Number of strings.
+ * @param doffset    Output array of nitems + 1 string offsets, sorted by ESID.
+ * @param ddata      Output buffer for the strings, sorted by ESID (it must be sized offset[nitems] bytes at least).
+ */
+static inline void build_esiddict(uint64_t *esid, uint64_t *tmp, uint32_t *idx, uint32_t *tdx, const char *data, const uint64_t *offset, uint32_t nitems, uint64_t *doffset, char *ddata)
+{
+    uint64_t pos = 0, size = 0;
+    uint32_t i = 0;
+    order_uint64_t(esid, tmp, idx, tdx, nitems);
+    for (i = 0; i < nitems; i++)
+    {
+        doffset[i] = pos;
+        size = (offset[(idx[i] + 1)] - offset[idx[i]]);
+        memcpy((ddata + pos), (data + offset[idx[i]]), (size_t)size);
+        pos += size;
+    }
+    doffset[nitems] = pos;
+}
+
+/**
+ * Build the minimal perfect hash index of a sorted ESID column.
+ * The keys are distributed in buckets of ESIDDICT_MPH_LAMBDA items on average,
+ * then, starting from the largest bucket, a displacement value is searched
+ * to place all the bucket keys in free slots.
+ *
+ * @param esid      ESID column sorted in ascending order (it must not contain duplicates).
+ * @param nrows     Number of rows (less than 2^32).
+ * @param disp      Output displacement column (it must be sized get_esiddict_mph_nbuckets(nrows) items at least).
+ * @param row       Output row column (it must be sized nrows items at least).
+ * @param tmp       Temporary array (it must be sized (2 * get_esiddict_mph_nbuckets(nrows)) + 1 + nrows items at least).
+ *
+ * @return 0 in case of success, 1 if the ESID column contains duplicates or the index can't be built.
+ */
+static inline int build_esiddict_mph(const uint64_t *esid, uint64_t nrows, uint32_t *disp, uint32_t *row, uint32_t *tmp)
+{
+    uint64_t nbuckets = get_esiddict_mph_nbuckets(nrows);
+    uint32_t *bstart = tmp;                      // first key of each bucket
+    uint32_t *keys = (tmp + nbuckets + 1);       // keys grouped by bucket
+    uint32_t *order = (keys + nrows);            // buckets sorted by decreasing size
+    uint64_t i = 0, b = 0, k = 0, n = 0, s = 0, maxsize = 0, slot = 0;
+    uint32_t d = 0;
+    for (i = 0; i <= nbuckets; i++)
+    {
+        bstart[i] = 0;
+    }
+    for (i = 0; i < nrows; i++)
+    {
+        if ((i > 0) && (esid[i] == esid[(i - 1)]))
+        {
+            return 1; // duplicate key
+        }
+        bstart[(esiddict_mph_bucket(esiddict_mix(esid[i]), nbuckets) + 1)]++;
+        row[i] = ESIDDICT_NOROW;
+    }
+    for (b = 0; b < nbuckets; b++)
+    {
+        s = bstart[(b + 1)];
+        maxsize = (s > maxsize) ? s : maxsize;
+        bstart[(b + 1)] += bstart[b];
+        order[b] = bstart[b]; // insertion cursor
+    }
+    for (i = 0; i < nrows; i++)
+    {
+        keys[order[esiddict_mph_bucket(esiddict_mix(esid[i]), nbuckets)]++] = (uint32_t)i;
+    }
+    for (s = maxsize, n = 0; s > 0; s--)
+    {
+        for (b = 0; b < nbuckets; b++)
+        {
+            if ((bstart[(b + 1)] - bstart[b]) == s)
+            {
+                order[n++] = (uint32_t)b;
+            }
+        }
+    }
+    for (b = 0; b < nbuckets; b++)
+    {
+        disp[b] = 0;
+    }
+    for (i = 0; i < n; i++)
+    {
+        b = order[i];
+        for (d = 0; d < ESIDDICT_NOROW; d++)
+        {
+            for (k = bstart[b]; k < bstart[(b + 1)]; k++)
+            {
+                slot = esiddict_mph_slot(esiddict_mix(esid[keys[k]]), d, nrows);
+                if (row[slot] != ESIDDICT_NOROW)
+                {
+                    break;
+                }
+                row[slot] = keys[k];
+            }
+            if (k == bstart[(b + 1)])
+            {
+                break; // all the bucket keys have been placed
+            }
+            while (k > bstart[b])
+            {
+                // undo the partial placement
+                --k;
+                row[esiddict_mph_slot(esiddict_mix(esid[keys[k]]), d, nrows)] = ESIDDICT_NOROW;
+            }
+        }
+        if (d == ESIDDICT_NOROW)
+        {
+            return 1;
+        }
+        disp[b] = d;
+    }
+    return 0;
+}
+
+/**
+ * Write the ESID dictionary file.
+ *
+ * @param file    Output file name. NOTE: existing files will be replaced.
+ * @param esid    ESID column sorted in ascending order.
+ * @param offset  String offset column (nrows + 1 items).
+ * @param data    String data column.
+ * @param nrows   Number of rows.
+ * @param disp    Displacement column returned by build_esiddict_mph, or NULL to write the file without the hash index.
+ * @param row     Row column returned by build_esiddict_mph, or NULL to write the file without the hash index.
+ *
+ * @return Number of written bytes or 0 in case of error.
+ */
+static inline size_t write_esiddict_file(const char *file, const uint64_t *esid, const uint64_t *offset, const char *data, uint64_t nrows, const uint32_t *disp, const uint32_t *row)
+{
+    const uint8_t ctbytes[5] = {8, 8, 1, 4, 4};
+    const void *cols[5] = {esid, offset, data, disp, row};
+    const uint64_t colsize[5] = {(nrows * 8), ((nrows + 1) * 8), offset[nrows], (get_esiddict_mph_nbuckets(nrows) * 4), (nrows * 4)};
+    uint8_t ncols = ((disp == NULL) || (row == NULL)) ? 3 : 5;
+    return write_binsrc1_file(file, nrows, ncols, ctbytes, cols, colsize);
+}
+
+/**
+ * Memory map the ESID dictionary file.
+ *
+ * @param file  Path to the file to map.
+ * @param mf    Structure containing the memory mapped file.
+ * @param edc   Structure containing the pointers to the memory mapped file columns.
+ */
+static inline void mmap_esiddict_file(const char *file, mmfile_t *mf, esiddict_cols_t *edc)
+{
+    mmap_binfile(file, mf);
+    edc->esid = (const uint64_t *)(mf->src + mf->index[0]);
+    edc->offset = (const uint64_t *)(mf->src + mf->index[1]);
+    edc->data = (const char *)(mf->src + mf->index[2]);
+    edc->nrows = mf->nrows;
+    edc->nbuckets = get_esiddict_mph_nbuckets(mf->nrows);
+    edc->disp = NULL;
+    edc->row = NULL;
+    if (mf->ncols == 5)
+    {
+        edc->disp = (const uint32_t *)(mf->src + mf->index[3]);
+        edc->row = (const uint32_t *)(mf->src + mf->index[4]);
+    }
+}
+
+/**
+ * Returns the dictionary row of the specified ESID.
+ * The minimal perfect hash index is used if available, otherwise the ESID column is searched.
+ *
+ * @param edc   Structure containing the pointers to the memory mapped file columns.
+ * @param esid  ESID code to search.
+ *
+ * @return Row number or edc.nrows if not found.
+ */
+static inline uint64_t find_esiddict_row(esiddict_cols_t edc, uint64_t esid)
+{
+    if ((edc.nrows == 0) || (esid > edc.esid[(edc.nrows - 1)]))
+    {
+        return edc.nrows;
+    }
+    if (edc.disp != NULL)
+    {
+        uint64_t h = esiddict_mix(esid);
+        uint64_t row = edc.row[esiddict_mph_slot(h, edc.disp[esiddict_mph_bucket(h, edc.nbuckets)], edc.nrows)];
+        return (edc.esid[row] == esid) ? row : edc.nrows;
+    }
+    uint64_t first = 0;
+    uint64_t max = edc.nrows;
+    return col_find_first_uint64_t(edc.esid, &first, &max, esid);
+}
+
+/**
+ * Returns the original string ID stored at the specified dictionary row (zero-copy).
+ *
+ * @param edc   Structure containing the pointers to the memory mapped file columns.
+ * @param row   Row number.
+ * @param str   Pointer to the returned string (not null terminated), or NULL if the row is not valid.
+ *
+ * @return String length or 0 if the row is not valid.
+ */
+static inline size_t get_esiddict_string_by_pos(esiddict_cols_t edc, uint64_t row, const char **str)
+{
+    if (row >= edc.nrows)
+    {
+        *str = NULL;
+        return 0;
+    }
+    *str = (edc.data + edc.offset[row]);
+    return (size_t)(edc.offset[(row + 1)] - edc.offset[row]);
+}
+
+/**
+ * Retrieve the original string ID for the specified ESID (zero-copy).
+ *
+ * @param edc   Structure containing the pointers to the memory mapped file columns.
+ * @param esid  ESID code to search.
+ * @param str   Pointer to the returned string (not null terminated), or NULL if the ESID is not found.
+ *
+ * @return String length or 0 if the ESID is not found.
+ */
+static inline size_t find_string_by_esid(esiddict_cols_t edc, uint64_t esid, const char **str)
+{
+    return get_esiddict_string_by_pos(edc, find_esiddict_row(edc, esid), str);
+}
+
+#endif  // VARIANTKEY_ESIDDICT_H
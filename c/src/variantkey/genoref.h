@@ -16,6 +16,26 @@
  *
  * The input reference binary files can be generated from a FASTA file using the
  * `resources/tools/fastabin.sh` script.
+ *
+ * A packed version of the reference binary file, about 4 times smaller, can be generated
+ * from the original one using the `write_genoref_packed_file` function.
+ * The ACGT bases are stored with 2 bits each, while all other symbols (e.g. N and IUPAC codes)
+ * and the lowercase letters are stored as sorted lists of runs.
+ * This file has the following "BINSRC1" format:
+ *
+ *     BINSRC1 00
+ *     07 08 01 08 08 01 08 08
+ *     [8 BYTE TOTAL NUMBER OF BASES]
+ *     [8 BYTE COLUMN OFFSET]+
+ *     [8 BYTE CHROMOSOME START OFFSET (27 ITEMS, AS THE INDEX SET BY mmap_genoref_file)]+
+ *     [1 BYTE 2-BIT PACKED BASES]+
+ *     [8 BYTE EXCEPTION RUN START]+
+ *     [8 BYTE EXCEPTION RUN END]+
+ *     [1 BYTE EXCEPTION RUN SYMBOL]+
+ *     [8 BYTE LOWERCASE RUN START]+
+ *     [8 BYTE LOWERCASE RUN END]+
+ *
+ * Both formats are supported transparently by all the functions in this file.
  */
 
 #ifndef VARIANTKEY_GENOREF_H
@@ -26,6 +46,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "binsearch.h"
+#include "set.h"
 #include "variantkey.h"
 
 #ifndef ALLELE_MAXSIZE
@@ -43,8 +64,64 @@
 #define NORM_RTRIM  (1 << 4) //!< Normalization: Alleles have been right trimmed.
 #define NORM_LTRIM  (1 << 5) //!< Normalization: Alleles have been left trimmed.
 
+#define GENOREF_NCOLS             27 //!< Number of index entries used by the genoref file (chromosome offsets).
+#define GENOREF_PACKED_FILE_NCOLS  7 //!< Number of columns in the packed genoref file.
+#define GENOREF_IDX_PACKED        27 //!< Index entry of the packed genoref 2-bit bases column.
+#define GENOREF_IDX_EXCSTART      28 //!< Index entry of the packed genoref exception run start column.
+#define GENOREF_IDX_EXCEND        29 //!< Index entry of the packed genoref exception run end column.
+#define GENOREF_IDX_EXCCHAR       30 //!< Index entry of the packed genoref exception run symbol column.
+#define GENOREF_IDX_NEXC          31 //!< Index entry containing the number of packed genoref exception runs.
+#define GENOREF_IDX_LOWSTART      32 //!< Index entry of the packed genoref lowercase run start column.
+#define GENOREF_IDX_LOWEND        33 //!< Index entry of the packed genoref lowercase run end column.
+#define GENOREF_IDX_NLOW          34 //!< Index entry containing the number of packed genoref lowercase runs.
+#define GENOREF_PACKED_NCOLS      35 //!< Number of index entries used by the packed genoref file.
+
+#define NORM_BATCH_PREFETCH        8 //!< Number of variants ahead to prefetch in normalize_variant_batch.
+
+#if defined(__clang__) || defined(__GNUC__)
+#define genoref_prefetch(addr) __builtin_prefetch(addr) //!< Prefetch the memory at the specified address.
+#else
+#define genoref_prefetch(addr) ((void)(addr)) //!< Prefetch not supported.
+#endif
+
+/**
+ * Variant to be normalized by normalize_variant_batch.
+ */
+typedef struct normvar_t
+{
+    char ref[ALLELE_MAXSIZE];  //!< Reference allele.
+    char alt[ALLELE_MAXSIZE];  //!< Alternate allele.
+    size_t sizeref;            //!< Length of the reference allele.
+    size_t sizealt;            //!< Length of the alternate allele.
+    uint32_t pos;              //!< Position, with the first base having position 0.
+    uint8_t chrom;             //!< Chromosome encoded number.
+    int status;                //!< Normalization return value (see normalize_variant).
+} normvar_t;
+
+/**
+ * Set the index of a memory mapped packed genoref file.
+ * The chromosome offsets are expressed in bases, and the columns offsets are stored after them.
+ *
+ * @param mf    Structure containing the memory mapped file.
+ */
+static inline void parse_genoref_packed_index(mmfile_t *mf)
+{
+    uint64_t col[GENOREF_PACKED_FILE_NCOLS];
+    memcpy(col, mf->index, sizeof(col));
+    memcpy(mf->index, (mf->src + col[0]), (GENOREF_NCOLS * sizeof(uint64_t)));
+    mf->index[GENOREF_IDX_PACKED] = col[1];
+    mf->index[GENOREF_IDX_EXCSTART] = col[2];
+    mf->index[GENOREF_IDX_EXCEND] = col[3];
+    mf->index[GENOREF_IDX_EXCCHAR] = col[4];
+    mf->index[GENOREF_IDX_NEXC] = ((col[3] - col[2]) / sizeof(uint64_t));
+    mf->index[GENOREF_IDX_LOWSTART] = col[5];
+    mf->index[GENOREF_IDX_LOWEND] = col[6];
+    mf->index[GENOREF_IDX_NLOW] = ((col[6] - col[5]) / sizeof(uint64_t));
+    mf->ncols = GENOREF_PACKED_NCOLS;
+}
+
 /**
- * Memory map the genoref binary file.
+ * Memory map the genoref binary file (original or packed format).
  *
  * @param file  Path to the file to map.
  * @param mf    Structure containing the memory mapped file.
@@ -52,6 +129,11 @@
 static inline void mmap_genoref_file(const char *file, mmfile_t *mf)
 {
     mmap_binfile(file, mf);
+    if ((mf->size > 0) && (mf->ncols == GENOREF_PACKED_FILE_NCOLS))
+    {
+        parse_genoref_packed_index(mf);
+        return;
+    }
     mf->index[26] = mf->size;
     int i = 25;
     while (i > 0)
@@ -59,7 +141,80 @@ static inline void mmap_genoref_file(const char *file, mmfile_t *mf)
         mf->index[i] = mf->index[(i - 1)];
         i--;
     }
-    mf->ncols = 27;
+    mf->ncols = GENOREF_NCOLS;
+}
+
+/**
+ * Returns the number of the first run starting after the specified position.
+ *
+ * @param start   Pointer to the column containing the run start positions, sorted in ascending order.
+ * @param nruns   Number of runs.
+ * @param pos     Position.
+ *
+ * @return Run number.
+ */
+static inline uint64_t find_genoref_run(const uint64_t *start, uint64_t nruns, uint64_t pos)
+{
+    uint64_t first = 0, middle = 0;
+    while (first < nruns)
+    {
+        middle = (first + ((nruns - first) >> 1));
+        if (start[middle] <= pos)
+        {
+            first = (middle + 1);
+        }
+        else
+        {
+            nruns = middle;
+        }
+    }
+    return first;
+}
+
+/**
+ * Decode a sequence from the packed genoref file.
+ *
+ * @param mf      Structure containing the memory mapped packed genoref file.
+ * @param offset  Offset of the first base (chromosome offset + position).
+ * @param size    Number of bases to decode.
+ * @param seq     Output buffer (it must be sized size bytes at least).
+ */
+static inline void get_genoref_packed_seq(mmfile_t mf, uint64_t offset, size_t size, char *seq)
+{
+    static const char base[4] = {'A', 'C', 'G', 'T'};
+    const uint8_t *packed = (const uint8_t *)(mf.src + mf.index[GENOREF_IDX_PACKED]);
+    const uint64_t *start = (const uint64_t *)(mf.src + mf.index[GENOREF_IDX_EXCSTART]);
+    const uint64_t *end = (const uint64_t *)(mf.src + mf.index[GENOREF_IDX_EXCEND]);
+    const uint8_t *sym = (const uint8_t *)(mf.src + mf.index[GENOREF_IDX_EXCCHAR]);
+    uint64_t nruns = mf.index[GENOREF_IDX_NEXC];
+    uint64_t last = (offset + size);
+    uint64_t i = 0, j = 0, k = 0;
+    for (i = 0; i < size; i++)
+    {
+        j = (offset + i);
+        seq[i] = base[((packed[(j >> 2)] >> ((j & 3) << 1)) & 3)];
+    }
+    // symbols other than ACGT
+    k = find_genoref_run(start, nruns, offset);
+    for (k = ((k > 0) ? (k - 1) : 0); (k < nruns) && (start[k] < last); k++)
+    {
+        for (j = ((start[k] > offset) ? start[k] : offset); (j < end[k]) && (j < last); j++)
+        {
+            seq[(j - offset)] = (char)sym[k];
+        }
+    }
+    // lowercase letters
+    start = (const uint64_t *)(mf.src + mf.index[GENOREF_IDX_LOWSTART]);
+    end = (const uint64_t *)(mf.src + mf.index[GENOREF_IDX_LOWEND]);
+    nruns = mf.index[GENOREF_IDX_NLOW];
+    k = find_genoref_run(start, nruns, offset);
+    for (k = ((k > 0) ? (k - 1) : 0); (k < nruns) && (start[k] < last); k++)
+    {
+        for (j = ((start[k] > offset) ? start[k] : offset); (j < end[k]) && (j < last); j++)
+        {
+            seq[(j - offset)] = (char)(seq[(j - offset)] | ('a' - 'A'));
+        }
+    }
 }
 
 /**
@@ -110,9 +265,118 @@ static inline char get_genoref_seq(mmfile_t mf, uint8_t chrom, uint32_t pos)
     {
         return 0; // invalid position
     }
+    if (mf.ncols == GENOREF_PACKED_NCOLS)
+    {
+        char ref = 0;
+        get_genoref_packed_seq(mf, offset, 1, &ref);
+        return ref;
+    }
     return  (char)*(mf.src + offset);
 }
 
+/**
+ * Check if the reference allele matches a genome reference sequence.
+ *
+ * @param gseq    Genome reference sequence (it must be sized sizeref bytes at least).
+ * @param ref     Reference allele. String containing a sequence of nucleotide letters.
+ * @param sizeref Length of the ref string, excluding the terminating null byte.
+ *
+ * @return Positive number in case of success, negative in case of error:
+ *       *  0 the reference allele match the reference genome;
+ *       *  1 the reference allele is inconsistent with the genome reference (i.e. when contains nucleotide letters other than A, C, G and T);
+ *       * -1 the reference allele don't match the reference genome.
+ */
+static inline int check_reference_seq(const char *gseq, const char *ref, size_t sizeref)
+{
+    /*
+        Abbreviation codes for degenerate bases
+
+        Cornish-Bowden A.
+        Nomenclature for incompletely specified bases in nucleic acid sequences: recommendations 1984.
+        Nucleic Acids Research. 1985;13(9):3021-3030.
+
+        SYMBOL | DESCRIPTION                   | BASES   | COMPLEMENT
+        -------+-------------------------------+---------+-----------
+           A   | Adenine                       | A       |  T
+           C   | Cytosine                      |   C     |  G
+           G   | Guanine                       |     G   |  C
+           T   | Thymine                       |       T |  A
+           W   | Weak                          | A     T |  W
+           S   | Strong                        |   C G   |  S
+           M   | aMino                         | A C     |  K
+           K   | Keto                          |     G T |  M
+           R   | puRine                        | A   G   |  Y
+           Y   | pYrimidine                    |   C   T |  R
+           B   | not A (B comes after A)       |   C G T |  V
+           D   | not C (D comes after C)       | A   G T |  H
+           H   | not G (H comes after G)       | A C   T |  D
+           V   | not T (V comes after T and U) | A C G   |  B
+           N   | aNy base (not a gap)          | A C G T |  N
+        -------+-------------------------------+---------+----------
+    */
+    /*
+        Compatibility table for degenerate bases.
+        The low byte contains the base class of each symbol: A=1, C=2, G=4, T=8, any other symbol=16.
+        The high byte contains the set of classes compatible with each degenerate base symbol.
+        Two different symbols are compatible if one of them allows the class of the other.
+    */
+    static const uint16_t iupac[256] =
+    {
+        0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010,
+        0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010,
+        0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010,
+        0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010,
+        0x0010, 0x0001, 0x1e10, 0x0002, 0x1d10, 0x0010, 0x0010, 0x0004, 0x1b10, 0x0010, 0x0010, 0x0c10, 0x0010, 0x0310, 0x1f10, 0x0010,
+        0x0010, 0x0010, 0x0510, 0x0610, 0x0008, 0x0010, 0x1710, 0x0910, 0x0010, 0x0a10, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010,
+        0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010,
+        0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010,
+        0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010,
+        0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010,
+        0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010,
+        0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010,
+        0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010,
+        0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010,
+        0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010,
+        0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010, 0x0010,
+    };
+    uint64_t r = 0, g = 0;
+    size_t i = 0, last = 0;
+    uint8_t uref = 0, gref = 0;
+    int ret = 0; // return value
+    while (i < sizeref)
+    {
+        last = sizeref;
+        if ((sizeref - i) >= 8)
+        {
+            // fast path: compare 8 ASCII bases at once after uppercasing the allele
+            memcpy(&r, (ref + i), 8);
+            memcpy(&g, (gseq + i), 8);
+            if (((r & 0x8080808080808080) == 0) && ((r ^ ((((r + 0x1f1f1f1f1f1f1f1f) & 0x8080808080808080) >> 2))) == g))
+            {
+                i += 8;
+                continue;
+            }
+            last = (i + 8);
+        }
+        for (; i < last; i++)
+        {
+            uref = (uint8_t) aztoupper(ref[i]);
+            gref = (uint8_t) gseq[i];
+            if (uref == gref)
+            {
+                continue;
+            }
+            if ((((iupac[uref] >> 8) & iupac[gref]) != 0) || (((iupac[gref] >> 8) & iupac[uref]) != 0))
+            {
+                ret = NORM_VALID; // valid but not consistent
+                continue;
+            }
+            return NORM_INVALID; // invalid reference
+        }
+    }
+    return ret; // sequence OK
+}
+
 /**
  * Check if the reference allele matches the reference genome data.
  *
@@ -131,87 +395,45 @@ static inline char get_genoref_seq(mmfile_t mf, uint8_t chrom, uint32_t pos)
 static inline int check_reference(mmfile_t mf, uint8_t chrom, uint32_t pos, const char *ref, size_t sizeref)
 {
     uint64_t offset = (mf.index[chrom] + pos);
-    if ((offset + sizeref - 1) >= mf.index[(chrom + 1)])
+    if ((offset + sizeref) > mf.index[(chrom + 1)])
     {
         return NORM_WRONGPOS;
     }
-    size_t i = 0;
-    char uref = 0, gref = 0;
-    int ret = 0; // return value
-    for (i = 0; i < sizeref; i++)
+    if (mf.ncols != GENOREF_PACKED_NCOLS)
     {
-        uref = (char) aztoupper(ref[i]);
-        gref = (char) mf.src[(offset + i)];
-        if (uref == gref)
-        {
-            continue;
-        }
-        /*
-            Abbreviation codes for degenerate bases
-
-            Cornish-Bowden A.
-            Nomenclature for incompletely specified bases in nucleic acid sequences: recommendations 1984.
-            Nucleic Acids Research. 1985;13(9):3021-3030.
-
-            SYMBOL | DESCRIPTION                   | BASES   | COMPLEMENT
-            -------+-------------------------------+---------+-----------
-               A   | Adenine                       | A       |  T
-               C   | Cytosine                      |   C     |  G
-               G   | Guanine                       |     G   |  C
-               T   | Thymine                       |       T |  A
-               W   | Weak                          | A     T |  W
-               S   | Strong                        |   C G   |  S
-               M   | aMino                         | A C     |  K
-               K   | Keto                          |     G T |  M
-               R   | puRine                        | A   G   |  Y
-               Y   | pYrimidine                    |   C   T |  R
-               B   | not A (B comes after A)       |   C G T |  V
-               D   | not C (D comes after C)       | A   G T |  H
-               H   | not G (H comes after G)       | A C   T |  D
-               V   | not T (V comes after T and U) | A C G   |  B
-               N   | aNy base (not a gap)          | A C G T |  N
-            -------+-------------------------------+---------+----------
-        */
-        if ((uref == 'N')
-                || (gref == 'N')
-                || ((uref == 'B') && (gref != 'A'))
-                || ((gref == 'B') && (uref != 'A'))
-                || ((uref == 'D') && (gref != 'C'))
-                || ((gref == 'D') && (uref != 'C'))
-                || ((uref == 'H') && (gref != 'G'))
-                || ((gref == 'H') && (uref != 'G'))
-                || ((uref == 'V') && (gref != 'T'))
-                || ((gref == 'V') && (uref != 'T'))
-                || ((uref == 'W') && ((gref == 'A') || (gref == 'T')))
-                || ((gref == 'W') && ((uref == 'A') || (uref == 'T')))
-                || ((uref == 'S') && ((gref == 'C') || (gref == 'G')))
-                || ((gref == 'S') && ((uref == 'C') || (uref == 'G')))
-                || ((uref == 'M') && ((gref == 'A') || (gref == 'C')))
-                || ((gref == 'M') && ((uref == 'A') || (uref == 'C')))
-                || ((uref == 'K') && ((gref == 'G') || (gref == 'T')))
-                || ((gref == 'K') && ((uref == 'G') || (uref == 'T')))
-                || ((uref == 'R') && ((gref == 'A') || (gref == 'G')))
-                || ((gref == 'R') && ((uref == 'A') || (uref == 'G')))
-                || ((uref == 'Y') && ((gref == 'C') || (gref == 'T')))
-                || ((gref == 'Y') && ((uref == 'C') || (uref == 'T'))))
+        return check_reference_seq((const char *)(mf.src + offset), ref, sizeref);
+    }
+    char gseq[ALLELE_MAXSIZE];
+    size_t size = 0;
+    int status = 0, ret = 0;
+    while (sizeref > 0)
+    {
+        size = ((sizeref < ALLELE_MAXSIZE) ? sizeref : ALLELE_MAXSIZE);
+        get_genoref_packed_seq(mf, offset, size, gseq);
+        status = check_reference_seq(gseq, ref, size);
+        if (status < 0)
         {
-            ret = NORM_VALID; // valid but not consistent
-            continue;
+            return status;
         }
-        return NORM_INVALID; // invalid reference
+        ret |= status;
+        offset += size;
+        ref += size;
+        sizeref -= size;
     }
-    return ret; // sequence OK
+    return ret;
 }
 
 /**
- * Flip the allele nucleotides (replaces each letter with its complement).
- * The resulting string is always in uppercase.
+ * Copy the complement of the allele nucleotides (replaces each letter with its complement).
+ * The resulting string is always in uppercase and null terminated.
  * Support extended nucleotide letters.
+ * The source and destination can be the same buffer.
  *
- * @param allele  Allele. String containing a sequence of nucleotide letters.
+ * @param dst     Output buffer (it must be sized size + 1 bytes at least).
+ * @param src     Allele. String containing a sequence of nucleotide letters.
  * @param size    Length of the allele string.
  */
-static inline void flip_allele(char *allele, size_t size)
+static inline void complement_allele(char *dst, const char *src, size_t size)
 {
     /*
       Byte map for allele flipping (complement):
@@ -242,9 +464,44 @@ static inline void flip_allele(char *allele, size_t size)
     size_t i = 0;
     for (i = 0; i < size; i++)
     {
-        allele[i] = map[((uint8_t)allele[i])];
+        dst[i] = map[((uint8_t)src[i])];
+    }
+    dst[size] = 0;
+}
+
+/**
+ * Flip the allele nucleotides (replaces each letter with its complement).
+ * The resulting string is always in uppercase.
+ * Support extended nucleotide letters.
+ *
+ * @param allele  Allele. String containing a sequence of nucleotide letters.
+ * @param size    Length of the allele string.
+ */
+static inline void flip_allele(char *allele, size_t size)
+{
+    complement_allele(allele, allele, size);
+}
+
+/**
+ * Reverse complement the allele nucleotides in place (e.g. to convert a sequence to the opposite strand).
+ * The resulting string is always in uppercase.
+ * Support extended nucleotide letters.
+ *
+ * @param allele  Allele. String containing a sequence of nucleotide letters.
+ * @param size    Length of the allele string.
+ */
+static inline void reverse_complement_allele(char *allele, size_t size)
+{
+    char tmp = 0;
+    size_t i = 0, j = size;
+    complement_allele(allele, allele, size);
+    while (i + 1 < j)
+    {
+        --j;
+        tmp = allele[i];
+        allele[i++] = allele[j];
+        allele[j] = tmp;
     }
-    allele[size] = 0;
 }
 
 /**
@@ -327,8 +584,7 @@ static inline int normalize_variant(mmfile_t mf, uint8_t chrom, uint32_t *pos, c
         }
         else
         {
-            strncpy(fref, ref, *sizeref);
-            flip_allele(fref, *sizeref);
+            complement_allele(fref, ref, *sizeref);
             status = check_reference(mf, chrom, *pos, fref, *sizeref);
             if (status >= 0)
             {
@@ -338,8 +594,7 @@ static inline int normalize_variant(mmfile_t mf, uint8_t chrom, uint32_t *pos, c
             }
             else
             {
-                strncpy(falt, alt, *sizealt);
-                flip_allele(falt, *sizealt);
+                complement_allele(falt, alt, *sizealt);
                 status = check_reference(mf, chrom, *pos, falt, *sizealt);
                 if (status >= 0)
                 {
@@ -365,7 +620,7 @@ static inline int normalize_variant(mmfile_t mf, uint8_t chrom, uint32_t *pos, c
         if (((*sizealt == 0) || (*sizeref == 0)) && (*pos > 0))
         {
             (*pos)--;
-            left = (char)mf.src[(mf.index[chrom] + *pos)];
+            left = get_genoref_seq(mf, chrom, *pos);
             prepend_char(left, alt, sizealt);
             prepend_char(left, ref, sizeref);
             status |= NORM_LEXT;
@@ -405,6 +660,61 @@ static inline int normalize_variant(mmfile_t mf, uint8_t chrom, uint32_t *pos, c
     return status;
 }
 
+/**
+ * Prefetch the genome reference data at the specified chromosome and position.
+ *
+ * @param mf      Structure containing the memory mapped file.
+ * @param chrom   Encoded Chromosome number (see encode_chrom).
+ * @param pos     Position. The reference position, with the first base having position 0.
+ */
+static inline void prefetch_genoref(mmfile_t mf, uint8_t chrom, uint32_t pos)
+{
+    uint64_t offset = (mf.index[chrom] + pos);
+    if (offset >= mf.index[(chrom + 1)])
+    {
+        return;
+    }
+    if (mf.ncols == GENOREF_PACKED_NCOLS)
+    {
+        offset = (mf.index[GENOREF_IDX_PACKED] + (offset >> 2));
+    }
+    genoref_prefetch(mf.src + offset);
+}
+
+/**
+ * Normalize an array of variants (see normalize_variant).
+ * The variants are processed in genome order (chromosome and position), to minimize the random access
+ * to the memory mapped genome reference, while the results are stored in place, in the original order.
+ *
+ * @param mf      Structure containing the memory mapped file.
+ * @param var     Pointer to the first element of the array of variants to normalize.
+ * @param nitems  Number of elements in the array.
+ * @param key     Temporary array used to sort the variants (it must be sized nitems items at least).
+ * @param tmp     Temporary array used to sort the variants (it must be sized nitems items at least).
+ * @param idx     Temporary array used to sort the variants (it must be sized nitems items at least).
+ * @param tdx     Temporary array used to sort the variants (it must be sized nitems items at least).
+ */
+static inline void normalize_variant_batch(mmfile_t mf, normvar_t *var, uint32_t nitems, uint64_t *key, uint64_t *tmp, uint32_t *idx, uint32_t *tdx)
+{
+    uint32_t i = 0;
+    normvar_t *v = NULL;
+    for (i = 0; i < nitems; i++)
+    {
+        key[i] = (((uint64_t)var[i].chrom << 32) | var[i].pos);
+    }
+    order_uint64_t(key, tmp, idx, tdx, nitems);
+    for (i = 0; i < nitems; i++)
+    {
+        if ((i + NORM_BATCH_PREFETCH) < nitems)
+        {
+            v = &var[idx[(i + NORM_BATCH_PREFETCH)]];
+            prefetch_genoref(mf, v->chrom, v->pos);
+        }
+        v = &var[idx[i]];
+        v->status = normalize_variant(mf, v->chrom, &v->pos, v->ref, &v->sizeref, v->alt, &v->sizealt);
+    }
+}
+
 /** @brief Returns a normalized 64 bit variant key based on CHROM, POS, REF, ALT.
  *
  * This function normalizes the variant using the genome reference data
@@ -435,4 +745,126 @@ static inline uint64_t normalized_variantkey(mmfile_t mf, const char *chrom, siz
     return encode_variantkey(echrom, *pos, encode_refalt(ref, *sizeref, alt, *sizealt));
 }
 
+/**
+ * Pack the sequences of an original genoref file.
+ * When the output buffers are NULL, only the number of runs is computed.
+ *
+ * @param mf        Structure containing the memory mapped original genoref file.
+ * @param packed    Output buffer for the 2-bit packed bases (it must be sized (number of bases + 3) / 4 bytes at least).
+ * @param excstart  Output buffer for the exception run start positions.
+ * @param excend    Output buffer for the exception run end positions.
+ * @param excchar   Output buffer for the exception run symbols.
+ * @param lowstart  Output buffer for the lowercase run start positions.
+ * @param lowend    Output buffer for the lowercase run end positions.
+ * @param nexc      Pointer to the returned number of exception runs.
+ * @param nlow      Pointer to the returned number of lowercase runs.
+ */
+static inline void pack_genoref(mmfile_t mf, uint8_t *packed, uint64_t *excstart, uint64_t *excend, uint8_t *excchar, uint64_t *lowstart, uint64_t *lowend, uint64_t *nexc, uint64_t *nlow)
+{
+    const uint8_t *src = (const uint8_t *)(mf.src + mf.index[1]);
+    uint64_t nbases = (mf.index[26] - mf.index[1]);
+    uint64_t i = 0, excnext = 0, lownext = 0;
+    uint8_t c = 0, code = 0, lastexc = 0;
+    *nexc = 0;
+    *nlow = 0;
+    for (i = 0; i < nbases; i++)
+    {
+        c = src[i];
+        if ((c >= 'a') && (c <= 'z'))
+        {
+            c = (uint8_t)(c ^ ('a' - 'A'));
+            if ((*nlow == 0) || (lownext != i))
+            {
+                if (lowstart != NULL)
+                {
+                    lowstart[*nlow] = i;
+                }
+                (*nlow)++;
+            }
+            lownext = (i + 1);
+            if (lowend != NULL)
+            {
+                lowend[(*nlow - 1)] = lownext;
+            }
+        }
+        switch (c)
+        {
+        case 'A':
+            code = 0;
+            break;
+        case 'C':
+            code = 1;
+            break;
+        case 'G':
+            code = 2;
+            break;
+        case 'T':
+            code = 3;
+            break;
+        default:
+            code = 0;
+            if ((*nexc == 0) || (excnext != i) || (lastexc != c))
+            {
+                if (excstart != NULL)
+                {
+                    excstart[*nexc] = i;
+                    excchar[*nexc] = c;
+                }
+                (*nexc)++;
+            }
+            lastexc = c;
+            excnext = (i + 1);
+            if (excend != NULL)
+            {
+                excend[(*nexc - 1)] = excnext;
+            }
+            break;
+        }
+        if (packed != NULL)
+        {
+            if ((i & 3) == 0)
+            {
+                packed[(i >> 2)] = 0;
+            }
+            packed[(i >> 2)] |= (uint8_t)(code << ((i & 3) << 1));
+        }
+    }
+}
+
+/**
+ * Write the packed genoref file from an original genoref file.
+ * The size of the exception and lowercase buffers can be obtained by calling pack_genoref with NULL buffers.
+ *
+ * @param mf        Structure containing the memory mapped original genoref file.
+ * @param file      Output file name. NOTE: existing files will be replaced.
+ * @param packed    Temporary buffer for the 2-bit packed bases (it must be sized (number of bases + 3) / 4 bytes at least).
+ * @param excstart  Temporary buffer for the exception run start positions.
+ * @param excend    Temporary buffer for the exception run end positions.
+ * @param excchar   Temporary buffer for the exception run symbols.
+ * @param lowstart  Temporary buffer for the lowercase run start positions.
+ * @param lowend    Temporary buffer for the lowercase run end positions.
+ *
+ * @return Number of written bytes or 0 in case of error.
+ */
+static inline size_t write_genoref_packed_file(mmfile_t mf, const char *file, uint8_t *packed, uint64_t *excstart, uint64_t *excend, uint8_t *excchar, uint64_t *lowstart, uint64_t *lowend)
+{
+    uint64_t chromoffset[GENOREF_NCOLS];
+    uint64_t nexc = 0, nlow = 0;
+    uint8_t i = 0;
+    if (mf.ncols != GENOREF_NCOLS)
+    {
+        return 0; // only the original format can be packed
+    }
+    for (i = 0; i < GENOREF_NCOLS; i++)
+    {
+        chromoffset[i] = (mf.index[i] - mf.index[1]);
+    }
+    pack_genoref(mf, packed, excstart, excend, excchar, lowstart, lowend, &nexc, &nlow);
+    uint64_t nbases = chromoffset[26];
+    const uint8_t ctbytes[GENOREF_PACKED_FILE_NCOLS] = {8, 1, 8, 8, 1, 8, 8};
+    const void *cols[GENOREF_PACKED_FILE_NCOLS] = {chromoffset, packed, excstart, excend, excchar, lowstart, lowend};
+    const uint64_t colsize[GENOREF_PACKED_FILE_NCOLS] = {sizeof(chromoffset), ((nbases + 3) >> 2), (nexc * 8), (nexc * 8), nexc, (nlow * 8), (nlow * 8)};
+    return write_binsrc1_file(file, nbases, GENOREF_PACKED_FILE_NCOLS, ctbytes, cols, colsize);
+}
+
 #endif  // VARIANTKEY_GENOREF_H
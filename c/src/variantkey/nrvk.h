@@ -25,6 +25,35 @@
  *
  *     b800c35bbcece603	AAAAAAAAGG	AG
  *     1800c351f61f65d3	A	AAGAAAGAAAG
+ *
+ * nrvk2.bin:
+ * Compressed version of nrvk.bin with the same VariantKey column.
+ * Rows containing only uppercase ACGT alleles are stored 2-bit packed, all other rows are stored as in nrvk.bin.
+ * The 8-byte offsets are replaced by one 8-byte base offset every NRVK2_BLOCK_SIZE rows and 2-byte deltas.
+ * The highest bit of each delta is set when the row is 2-bit packed.
+ * This binary file can be generated by the `write_nrvk2_file` function
+ * and has the following "BINSRC1" format:
+ *
+ *     BINSRC1 00
+ *     04 08 08 02 01 00 00 00
+ *     [8 BYTE NUMBER OF ROWS]
+ *     [8 BYTE COLUMN OFFSET]+
+ *     [8 BYTE VARIANTKEY COLUMN SORTED IN ASCENDING ORDER]+
+ *     [8 BYTE BLOCK BASE OFFSET]+
+ *     [2 BYTE ROW DELTA OFFSET]+
+ *     [1 BYTE REF LENGTH][1 BYTE ALT LENGTH][REF+ALT DATA]+
+ *
+ * nrvkref.bin:
+ * Optional companion file containing the REF length of each NRVK row,
+ * aligned to the VariantKey column, to avoid accessing the Offset and Data columns.
+ * This binary file can be generated by the `write_nrvk_reflen_file` function
+ * and has the following "BINSRC1" format:
+ *
+ *     BINSRC1 00
+ *     01 01 00 00 00 00 00 00
+ *     [8 BYTE NUMBER OF ROWS]
+ *     [8 BYTE COLUMN OFFSET]
+ *     [1 BYTE REF LENGTH COLUMN]+
  */
 
 #ifndef VARIANTKEY_NRVK_H
@@ -41,6 +70,13 @@
 #define ALLELE_MAXSIZE 256 //!< Maximum allele length.
 #endif
 
+#define NRVK2_BLOCK_BITS 6                         //!< Number of bits used to address the rows of an NRVK v2 offset block.
+#define NRVK2_BLOCK_SIZE (1 << NRVK2_BLOCK_BITS)   //!< Number of rows in each NRVK v2 offset block.
+#define NRVK2_PACKED_FLAG 0x8000                   //!< NRVK v2 delta flag for 2-bit packed rows.
+#define NRVK2_DELTA_MASK 0x7fff                    //!< NRVK v2 delta offset mask.
+#define NRVK_CACHE_BITS 8                          //!< Number of bits used to address the NRVK REF length cache.
+#define NRVK_CACHE_SIZE (1 << NRVK_CACHE_BITS)     //!< Number of entries of the NRVK REF length cache.
+
 /**
  * VariantKey decoded struct
  */
@@ -60,13 +96,25 @@ typedef struct variantkey_rev_t
 typedef struct nrvk_cols_t
 {
     const uint64_t *vk;      //!< Pointer to the VariantKey column.
-    const uint64_t *offset;  //!< Pointer to the Offset column.
+    const uint64_t *offset;  //!< Pointer to the Offset column (block base offsets for the v2 format).
     const uint8_t  *data;    //!< Pointer to the Data column.
     uint64_t nrows;          //!< Number of rows.
+    const uint8_t  *reflen;  //!< Pointer to the optional REF length column (NULL if not available).
+    const uint16_t *delta;   //!< Pointer to the v2 delta offset column (NULL for the v1 format).
 } nrvk_cols_t;
 
 /**
- * Memory map the NRVK binary file.
+ * Direct-mapped cache of the REF lengths of recently resolved non-reversible VariantKeys.
+ * It must be zero-initialized before use (non-reversible VariantKeys are never zero).
+ */
+typedef struct nrvk_cache_t
+{
+    uint64_t vk[NRVK_CACHE_SIZE];      //!< Cached VariantKeys.
+    uint32_t reflen[NRVK_CACHE_SIZE];  //!< Cached REF lengths.
+} nrvk_cache_t;
+
+/**
+ * Memory map the NRVK binary file (v1 or v2 format).
  *
  * @param file  Path to the file to map.
  * @param mf    Structure containing the memory mapped file.
@@ -77,8 +125,115 @@ static inline void mmap_nrvk_file(const char *file, mmfile_t *mf, nrvk_cols_t *n
     mmap_binfile(file, mf);
     nvc->vk = (const uint64_t *)(mf->src + mf->index[0]);
     nvc->offset = (const uint64_t *)(mf->src + mf->index[1]);
-    nvc->data = (const uint8_t *)(mf->src + mf->index[2]);
     nvc->nrows = mf->nrows;
+    nvc->reflen = NULL;
+    nvc->delta = NULL;
+    if (mf->ncols == 4)
+    {
+        nvc->delta = (const uint16_t *)(mf->src + mf->index[2]);
+        nvc->data = (const uint8_t *)(mf->src + mf->index[3]);
+        return;
+    }
+    nvc->data = (const uint8_t *)(mf->src + mf->index[2]);
+}
+
+/**
+ * Returns a pointer to the data of the specified NRVK row.
+ *
+ * @param nvc      Structure containing the pointers to the memory mapped file columns.
+ * @param row      Row number (it must be less than nvc.nrows).
+ * @param packed   Pointer to the returned flag: 1 if the alleles are 2-bit packed, 0 otherwise.
+ *
+ * @return Pointer to the row data: [1 BYTE REF LENGTH][1 BYTE ALT LENGTH][REF+ALT DATA].
+ */
+static inline const uint8_t *get_nrvk_row_data(nrvk_cols_t nvc, uint64_t row, uint8_t *packed)
+{
+    if (nvc.delta == NULL)
+    {
+        *packed = 0;
+        return (nvc.data + *(nvc.offset + row));
+    }
+    uint16_t d = nvc.delta[row];
+    *packed = (uint8_t)(d >> 15);
+    return (nvc.data + nvc.offset[(row >> NRVK2_BLOCK_BITS)] + (d & NRVK2_DELTA_MASK));
+}
+
+/**
+ * Unpack a 2-bit encoded allele.
+ *
+ * @param src      Pointer to the packed data.
+ * @param start    Index of the first base to unpack.
+ * @param size     Number of bases to unpack.
+ * @param allele   Output allele buffer (it must be sized size + 1 bytes at least).
+ */
+static inline void unpack_nrvk2_allele(const uint8_t *src, size_t start, size_t size, char *allele)
+{
+    static const char base[4] = {'A', 'C', 'G', 'T'};
+    size_t i = 0, j = 0;
+    for (i = 0; i < size; i++)
+    {
+        j = (start + i);
+        allele[i] = base[((src[(j >> 2)] >> ((j & 3) << 1)) & 3)];
+    }
+    allele[size] = 0;
+}
+
+/**
+ * Write the REF length companion file of the specified NRVK file.
+ *
+ * @param nvc   Structure containing the pointers to the memory mapped file columns.
+ * @param file  Output file name. NOTE: existing files will be replaced.
+ * @param tmp   Pointer to a temporary buffer of nvc.nrows bytes.
+ *
+ * @return Number of written bytes or 0 in case of error.
+ */
+static inline size_t write_nrvk_reflen_file(nrvk_cols_t nvc, const char *file, uint8_t *tmp)
+{
+    uint64_t i = 0;
+    uint8_t packed = 0;
+    for (i = 0; i < nvc.nrows; i++)
+    {
+        tmp[i] = *get_nrvk_row_data(nvc, i, &packed);
+    }
+    const uint8_t ctbytes[1] = {1};
+    const void *cols[1] = {tmp};
+    const uint64_t colsize[1] = {nvc.nrows};
+    return write_binsrc1_file(file, nvc.nrows, 1, ctbytes, cols, colsize);
+}
+
+/**
+ * Memory map the REF length companion file and attach it to the NRVK columns.
+ * The column is ignored if the number of rows does not match the NRVK file.
+ *
+ * @param file  Path to the file to map.
+ * @param mf    Structure containing the memory mapped file.
+ * @param nvc   Structure containing the pointers to the NRVK memory mapped file columns.
+ */
+static inline void mmap_nrvk_reflen_file(const char *file, mmfile_t *mf, nrvk_cols_t *nvc)
+{
+    mmap_binfile(file, mf);
+    if ((mf->ncols == 1) && (mf->nrows == nvc->nrows))
+    {
+        nvc->reflen = (const uint8_t *)(mf->src + mf->index[0]);
+    }
+}
+
+/**
+ * Returns the REF length stored in the specified NRVK row.
+ *
+ * @param nvc      Structure containing the pointers to the memory mapped file columns.
+ * @param row      Row number (it must be less than nvc.nrows).
+ *
+ * @return REF length.
+ */
+static inline size_t get_nrvk_reflen_by_pos(nrvk_cols_t nvc, uint64_t row)
+{
+    if (nvc.reflen != NULL)
+    {
+        return (size_t)nvc.reflen[row];
+    }
+    uint8_t packed = 0;
+    return (size_t)(*get_nrvk_row_data(nvc, row, &packed));
 }
 
 /**
@@ -101,9 +256,16 @@ static inline size_t get_nrvk_ref_alt_by_pos(nrvk_cols_t nvc, uint64_t pos, char
     {
         return 0; // not found
     }
-    const uint8_t *data = (nvc.data + *(nvc.offset + pos));
+    uint8_t packed = 0;
+    const uint8_t *data = get_nrvk_row_data(nvc, pos, &packed);
     *sizeref = (size_t)(*(data++));
     *sizealt = (size_t)(*(data++));
+    if (packed)
+    {
+        unpack_nrvk2_allele(data, 0, *sizeref, ref);
+        unpack_nrvk2_allele(data, *sizeref, *sizealt, alt);
+        return (*sizeref + *sizealt);
+    }
     memcpy(ref, data, *sizeref);
     ref[*sizeref] = 0;
     memcpy(alt, (data + *sizeref), *sizealt);
@@ -175,7 +337,75 @@ static inline size_t get_variantkey_ref_length(nrvk_cols_t nvc, uint64_t vk)
     {
         return 0; // not found
     }
-    return (size_t)(*(nvc.data + *(nvc.offset + found)));
+    return get_nrvk_reflen_by_pos(nvc, found);
+}
+
+/**
+ * Retrieve the REF length for the specified VariantKey using a cache of recently resolved non-reversible VariantKeys.
+ *
+ * @param nvc      Structure containing the pointers to the memory mapped file columns.
+ * @param cache    Pointer to a zero-initialized cache, owned by the caller (not thread-safe).
+ * @param vk       VariantKey.
+ *
+ * @return REF length or 0 if the VariantKey is not reversible and not found.
+ */
+static inline size_t get_variantkey_ref_length_cached(nrvk_cols_t nvc, nrvk_cache_t *cache, uint64_t vk)
+{
+    if ((vk & 0x1) == 0) // check last bit for reversible encoding
+    {
+        return ((vk & 0x0000000078000000) >> 27);
+    }
+    uint64_t slot = ((vk * 0x9e3779b97f4a7c15) >> (64 - NRVK_CACHE_BITS));
+    if (cache->vk[slot] != vk)
+    {
+        cache->vk[slot] = vk;
+        cache->reflen[slot] = (uint32_t)get_variantkey_ref_length(nvc, vk);
+    }
+    return (size_t)cache->reflen[slot];
+}
+
+/**
+ * Retrieve the REF length for the specified non-reversible VariantKey, resuming the search from a previous position.
+ * When called in a loop with VariantKeys sorted in ascending order, each search only considers the remaining rows.
+ * The search restarts from the beginning if the VariantKey is smaller than the one at the current position.
+ *
+ * @param nvc      Structure containing the pointers to the memory mapped file columns.
+ * @param first    Pointer to the row where to start the search (initially 0). This will be updated for the next search.
+ * @param vk       Non-reversible VariantKey.
+ *
+ * @return REF length or 0 if the VariantKey is not found.
+ */
+static inline size_t find_nrvk_ref_length_from(nrvk_cols_t nvc, uint64_t *first, uint64_t vk)
+{
+    if ((nvc.nrows == 0) || (vk > nvc.vk[(nvc.nrows - 1)]))
+    {
+        return 0; // not found
+    }
+    if ((*first >= nvc.nrows) || (vk < nvc.vk[*first]))
+    {
+        *first = 0;
+    }
+    uint64_t max = nvc.nrows;
+    uint64_t found = col_find_first_uint64_t(nvc.vk, first, &max, vk);
+    if (found >= nvc.nrows)
+    {
+        return 0; // not found
+    }
+    return get_nrvk_reflen_by_pos(nvc, found);
+}
+
+/**
+ * Get the VariantKey end position (POS + REF length) without NRVK lookup.
+ * For non-reversible VariantKeys this returns the position.
+ *
+ * @param vk       VariantKey.
+ *
+ * @return Variant end position (POS + REF length) for reversible VariantKeys, POS otherwise.
+ */
+static inline uint32_t get_variantkey_endpos_rev(uint64_t vk)
+{
+    // the REF length bits are masked out when the last bit is set (non-reversible encoding)
+    return (extract_variantkey_pos(vk) + ((uint32_t)((vk & 0x0000000078000000) >> 27) & ((uint32_t)(vk & 0x1) - 1)));
 }
 
 /**
@@ -191,6 +421,47 @@ static inline uint32_t get_variantkey_endpos(nrvk_cols_t nvc, uint64_t vk)
     return (extract_variantkey_pos(vk) + (uint32_t)get_variantkey_ref_length(nvc, vk));
 }
 
+/**
+ * Get the VariantKey end position (POS + REF length) using a cache of recently resolved non-reversible VariantKeys.
+ *
+ * @param nvc      Structure containing the pointers to the memory mapped file columns.
+ * @param cache    Pointer to a zero-initialized cache, owned by the caller (not thread-safe).
+ * @param vk       VariantKey.
+ *
+ * @return Variant end position (POS + REF length).
+ */
+static inline uint32_t get_variantkey_endpos_cached(nrvk_cols_t nvc, nrvk_cache_t *cache, uint64_t vk)
+{
+    return (extract_variantkey_pos(vk) + (uint32_t)get_variantkey_ref_length_cached(nvc, cache, vk));
+}
+
+/**
+ * Get the end positions (POS + REF length) of an array of VariantKeys.
+ * The reversible VariantKeys are processed first in a branchless loop,
+ * then the non-reversible ones are resolved with a single forward pass on the NRVK file
+ * (fastest when the input is sorted in ascending order).
+ *
+ * @param nvc      Structure containing the pointers to the memory mapped file columns.
+ * @param vk       Pointer to the first element of the VariantKey array.
+ * @param nitems   Number of elements in the array.
+ * @param endpos   Pointer to the first element of the output array (it must be sized nitems items at least).
+ */
+static inline void get_variantkey_endpos_array(nrvk_cols_t nvc, const uint64_t *vk, uint64_t nitems, uint32_t *endpos)
+{
+    uint64_t i = 0, first = 0;
+    for (i = 0; i < nitems; i++)
+    {
+        endpos[i] = get_variantkey_endpos_rev(vk[i]);
+    }
+    for (i = 0; i < nitems; i++)
+    {
+        if (vk[i] & 0x1)
+        {
+            endpos[i] += (uint32_t)find_nrvk_ref_length_from(nvc, &first, vk[i]);
+        }
+    }
+}
+
 /** @brief Get the CHROM + START POS encoding from VariantKey.
  *
  * @param vk VariantKey code.
@@ -244,4 +515,121 @@ static inline size_t nrvk_bin_to_tsv(nrvk_cols_t nvc, const char *tsvfile)
     return len;
 }
 
+/**
+ * Returns 1 if the REF and ALT of the specified row data contain only uppercase ACGT bases, 0 otherwise.
+ *
+ * @param data     Pointer to the row data: [1 BYTE REF LENGTH][1 BYTE ALT LENGTH][REF+ALT DATA].
+ *
+ * @return 1 if the row can be 2-bit packed, 0 otherwise.
+ */
+static inline uint8_t is_nrvk2_packable(const uint8_t *data)
+{
+    size_t i = 0, size = ((size_t)data[0] + data[1]);
+    for (i = 0; i < size; i++)
+    {
+        switch (data[(2 + i)])
+        {
+        case 'A':
+        case 'C':
+        case 'G':
+        case 'T':
+            break;
+        default:
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Returns the number of bytes required to store the specified row data in the NRVK v2 format.
+ *
+ * @param data     Pointer to the row data: [1 BYTE REF LENGTH][1 BYTE ALT LENGTH][REF+ALT DATA].
+ *
+ * @return Number of bytes.
+ */
+static inline size_t get_nrvk2_row_size(const uint8_t *data)
+{
+    size_t size = ((size_t)data[0] + data[1]);
+    if (is_nrvk2_packable(data))
+    {
+        return (2 + ((size + 3) >> 2));
+    }
+    return (2 + size);
+}
+
+/**
+ * Returns the size of the NRVK v2 Data column for the specified NRVK columns.
+ *
+ * @param nvc      Structure containing the pointers to the memory mapped file columns.
+ *
+ * @return Number of bytes.
+ */
+static inline uint64_t get_nrvk2_data_size(nrvk_cols_t nvc)
+{
+    uint64_t i = 0, size = 0;
+    uint8_t packed = 0;
+    for (i = 0; i < nvc.nrows; i++)
+    {
+        size += get_nrvk2_row_size(get_nrvk_row_data(nvc, i, &packed));
+    }
+    return size;
+}
+
+/**
+ * Write the NRVK v2 compressed file from NRVK columns in v1 format.
+ *
+ * @param nvc      Structure containing the pointers to the NRVK v1 memory mapped file columns.
+ * @param file     Output file name. NOTE: existing files will be replaced.
+ * @param base     Temporary buffer for the block base offsets (it must be sized (nvc.nrows + NRVK2_BLOCK_SIZE - 1) / NRVK2_BLOCK_SIZE items at least).
+ * @param delta    Temporary buffer for the row delta offsets (it must be sized nvc.nrows items at least).
+ * @param data     Temporary buffer for the data (it must be sized get_nrvk2_data_size(nvc) bytes at least).
+ *
+ * @return Number of written bytes or 0 in case of error.
+ */
+static inline size_t write_nrvk2_file(nrvk_cols_t nvc, const char *file, uint64_t *base, uint16_t *delta, uint8_t *data)
+{
+    uint64_t i = 0, pos = 0;
+    size_t j = 0, size = 0;
+    const uint8_t *src = NULL;
+    uint8_t *dst = NULL;
+    uint8_t packed = 0;
+    if (nvc.delta != NULL)
+    {
+        return 0; // already in v2 format
+    }
+    for (i = 0; i < nvc.nrows; i++)
+    {
+        if ((i & (NRVK2_BLOCK_SIZE - 1)) == 0)
+        {
+            base[(i >> NRVK2_BLOCK_BITS)] = pos;
+        }
+        src = get_nrvk_row_data(nvc, i, &packed);
+        packed = is_nrvk2_packable(src);
+        delta[i] = (uint16_t)((pos - base[(i >> NRVK2_BLOCK_BITS)]) | (packed ? NRVK2_PACKED_FLAG : 0));
+        dst = (data + pos);
+        size = ((size_t)src[0] + src[1]);
+        dst[0] = src[0];
+        dst[1] = src[1];
+        pos += get_nrvk2_row_size(src);
+        src += 2;
+        dst += 2;
+        if (packed == 0)
+        {
+            memcpy(dst, src, size);
+            continue;
+        }
+        memset(dst, 0, ((size + 3) >> 2));
+        for (j = 0; j < size; j++)
+        {
+            // A=0, C=1, G=2, T=3
+            dst[(j >> 2)] |= (uint8_t)((((src[j] >> 1) ^ (src[j] >> 2)) & 3) << ((j & 3) << 1));
+        }
+    }
+    const uint8_t ctbytes[4] = {8, 8, 2, 1};
+    const void *cols[4] = {nvc.vk, base, delta, data};
+    const uint64_t colsize[4] = {(nvc.nrows * 8), (((nvc.nrows + NRVK2_BLOCK_SIZE - 1) >> NRVK2_BLOCK_BITS) * 8), (nvc.nrows * 2), pos};
+    return write_binsrc1_file(file, nvc.nrows, 4, ctbytes, cols, colsize);
+}
+
 #endif  // VARIANTKEY_NRVK_H
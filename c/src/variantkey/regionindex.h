@@ -0,0 +1,275 @@
+// VariantKey
+//
+// regionindex.h
+//
+// @category   Libraries
+// @author     Nicola Asuni <info@tecnick.com>
+// @link       https://github.com/tecnickcom/variantkey
+// @license    MIT [LICENSE](https://raw.githubusercontent.com/tecnickcom/variantkey/main/LICENSE)
+
+/**
+ * @file regionindex.h
+ * @brief Functions to search regions overlapping a query from a RegionKey interval index.
+ *
+ * The functions provided here allows to find all the rows of a sorted RegionKey column
+ * overlapping a given region or variant, without a full scan.
+ *
+ * The index is an implicit augmented interval tree (as in cgranges):
+ * the sorted RegionKey column is interpreted as an in-order binary tree
+ * and a companion column stores, for each node, the maximum CHROM + END POS of its subtree.
+ *
+ * rkidx.bin:
+ * Interval index for RegionKeys.
+ * This binary file can be generated by the `write_regionkey_index_file` function
+ * and has the following "BINSRC1" format:
+ *
+ *     BINSRC1 00
+ *     02 08 08 00 00 00 00 00
+ *     [8 BYTE NUMBER OF ROWS]
+ *     [8 BYTE COLUMN OFFSET]+
+ *     [8 BYTE REGIONKEY COLUMN SORTED IN ASCENDING ORDER]+
+ *     [8 BYTE MAXIMUM CHROM + END POS COLUMN]+
+ */
+
+#ifndef VARIANTKEY_REGIONINDEX_H
+#define VARIANTKEY_REGIONINDEX_H
+
+#include <inttypes.h>
+#include <stdint.h>
+#include "binsearch.h"
+#include "regionkey.h"
+
+#define RKI_MAXDEPTH 128 //!< Maximum depth of the implicit interval tree traversal stack.
+#define RKI_SCANK      3 //!< Subtrees with this level or less are linearly scanned.
+
+/**
+ * Struct containing the RegionKey interval index column info.
+ */
+typedef struct rkindex_cols_t
+{
+    const uint64_t *rk;     //!< Pointer to the RegionKey column (sorted in ascending order).
+    const uint64_t *maxend; //!< Pointer to the column containing the maximum CHROM + END POS of each subtree.
+    uint64_t nrows;         //!< Number of rows.
+    uint8_t rootk;          //!< Level of the root node of the implicit interval tree.
+} rkindex_cols_t;
+
+/**
+ * Returns the level of the root node of the implicit interval tree for the specified number of rows.
+ *
+ * @param nrows  Number of rows.
+ *
+ * @return Root level.
+ */
+static inline uint8_t get_regionkey_index_rootk(uint64_t nrows)
+{
+    uint8_t k = 0;
+    while ((nrows >> 1) > 0)
+    {
+        nrows >>= 1;
+        k++;
+    }
+    return k;
+}
+
+/**
+ * Build the maximum CHROM + END POS column of the implicit interval tree.
+ *
+ * @param rk      Pointer to the RegionKey column, sorted in ascending order.
+ * @param nrows   Number of rows.
+ * @param maxend  Pointer to the output column (it must be sized nrows items at least).
+ *
+ * @return Level of the root node.
+ */
+static inline uint8_t build_regionkey_index(const uint64_t *rk, uint64_t nrows, uint64_t *maxend)
+{
+    uint64_t i = 0, x = 0, lasti = 0, last = 0, e = 0, el = 0, er = 0;
+    uint8_t k = 0;
+    for (i = 0; i < nrows; i += 2)
+    {
+        lasti = i;
+        last = maxend[i] = get_regionkey_chrom_endpos(rk[i]); // leaves
+    }
+    for (k = 1; ((uint64_t)1 << k) <= nrows; ++k)
+    {
+        x = ((uint64_t)1 << (k - 1));
+        for (i = ((x << 1) - 1); i < nrows; i += (x << 2))
+        {
+            el = maxend[(i - x)];
+            er = ((i + x) < nrows) ? maxend[(i + x)] : last;
+            e = get_regionkey_chrom_endpos(rk[i]);
+            e = (e > el) ? e : el;
+            maxend[i] = (e > er) ? e : er;
+        }
+        lasti = ((lasti >> k) & 1) ? lasti : (lasti + x);
+        if ((lasti < nrows) && (maxend[lasti] > last))
+        {
+            last = maxend[lasti];
+        }
+    }
+    return get_regionkey_index_rootk(nrows);
+}
+
+/**
+ * Write the RegionKey interval index file.
+ *
+ * @param file    Output file name. NOTE: existing files will be replaced.
+ * @param rk      Pointer to the RegionKey column, sorted in ascending order.
+ * @param maxend  Pointer to the column returned by build_regionkey_index.
+ * @param nrows   Number of rows.
+ *
+ * @return Number of written bytes or 0 in case of error.
+ */
+static inline size_t write_regionkey_index_file(const char *file, const uint64_t *rk, const uint64_t *maxend, uint64_t nrows)
+{
+    const uint8_t ctbytes[2] = {8, 8};
+    const void *cols[2] = {rk, maxend};
+    const uint64_t colsize[2] = {(nrows * 8), (nrows * 8)};
+    return write_binsrc1_file(file, nrows, 2, ctbytes, cols, colsize);
+}
+
+/**
+ * Memory map the RegionKey interval index file.
+ *
+ * @param file  Path to the file to map.
+ * @param mf    Structure containing the memory mapped file.
+ * @param rki   Structure containing the pointers to the memory mapped file columns.
+ */
+static inline void mmap_rkindex_file(const char *file, mmfile_t *mf, rkindex_cols_t *rki)
+{
+    mmap_binfile(file, mf);
+    rki->rk = (const uint64_t *)(mf->src + mf->index[0]);
+    rki->maxend = (const uint64_t *)(mf->src + mf->index[1]);
+    rki->nrows = mf->nrows;
+    rki->rootk = get_regionkey_index_rootk(mf->nrows);
+}
+
+/**
+ * Find all the RegionKey rows overlapping the specified region.
+ * The row numbers are returned in ascending order.
+ *
+ * @param rki       Structure containing the pointers to the RegionKey interval index columns.
+ * @param chrom     Chromosome encoded number.
+ * @param startpos  Region start position (zero based).
+ * @param endpos    Region end position (startpos + region length).
+ * @param rows      Output buffer for the overlapping row numbers.
+ * @param maxrows   Size of the rows buffer. Only the first maxrows results are stored.
+ *
+ * @return Total number of overlapping rows (it can be greater than maxrows).
+ */
+static inline uint64_t find_region_regionkey_overlaps(rkindex_cols_t rki, uint8_t chrom, uint32_t startpos, uint32_t endpos, uint64_t *rows, uint64_t maxrows)
+{
+    struct
+    {
+        uint64_t x; // node
+        uint8_t k;  // level
+        uint8_t w;  // 1 if the left child has been processed
+    } stack[RKI_MAXDEPTH];
+    uint64_t qstart = (((uint64_t)chrom << 28) | startpos);
+    uint64_t qend = (((uint64_t)chrom << 28) | endpos);
+    uint64_t n = 0, i = 0, i0 = 0, i1 = 0, y = 0, x = 0;
+    uint8_t k = 0, w = 0;
+    int t = 0;
+    if (rki.nrows == 0)
+    {
+        return 0;
+    }
+    stack[t].x = (((uint64_t)1 << rki.rootk) - 1);
+    stack[t].k = rki.rootk;
+    stack[t++].w = 0;
+    while (t > 0)
+    {
+        --t;
+        x = stack[t].x;
+        k = stack[t].k;
+        w = stack[t].w;
+        if (k <= RKI_SCANK)
+        {
+            // small subtree: scan every node
+            i0 = ((x >> k) << k);
+            i1 = (i0 + ((uint64_t)1 << (k + 1)) - 1);
+            if (i1 > rki.nrows)
+            {
+                i1 = rki.nrows;
+            }
+            for (i = i0; (i < i1) && (get_regionkey_chrom_startpos(rki.rk[i]) < qend); ++i)
+            {
+                if (qstart < get_regionkey_chrom_endpos(rki.rk[i]))
+                {
+                    if (n < maxrows)
+                    {
+                        rows[n] = i;
+                    }
+                    n++;
+                }
+            }
+            continue;
+        }
+        if (w == 0)
+        {
+            // re-add the node marking the left child as processed
+            y = (x - ((uint64_t)1 << (k - 1)));
+            stack[t].x = x;
+            stack[t].k = k;
+            stack[t++].w = 1;
+            if ((y >= rki.nrows) || (rki.maxend[y] > qstart))
+            {
+                // push the left child
+                stack[t].x = y;
+                stack[t].k = (uint8_t)(k - 1);
+                stack[t++].w = 0;
+            }
+            continue;
+        }
+        if ((x < rki.nrows) && (get_regionkey_chrom_startpos(rki.rk[x]) < qend))
+        {
+            if (qstart < get_regionkey_chrom_endpos(rki.rk[x]))
+            {
+                if (n < maxrows)
+                {
+                    rows[n] = x;
+                }
+                n++;
+            }
+            // push the right child
+            stack[t].x = (x + ((uint64_t)1 << (k - 1)));
+            stack[t].k = (uint8_t)(k - 1);
+            stack[t++].w = 0;
+        }
+    }
+    return n;
+}
+
+/**
+ * Find all the RegionKey rows overlapping the specified RegionKey.
+ * The row numbers are returned in ascending order.
+ *
+ * @param rki       Structure containing the pointers to the RegionKey interval index columns.
+ * @param rk        RegionKey code.
+ * @param rows      Output buffer for the overlapping row numbers.
+ * @param maxrows   Size of the rows buffer. Only the first maxrows results are stored.
+ *
+ * @return Total number of overlapping rows (it can be greater than maxrows).
+ */
+static inline uint64_t find_regionkey_overlaps(rkindex_cols_t rki, uint64_t rk, uint64_t *rows, uint64_t maxrows)
+{
+    return find_region_regionkey_overlaps(rki, extract_regionkey_chrom(rk), extract_regionkey_startpos(rk), extract_regionkey_endpos(rk), rows, maxrows);
+}
+
+/**
+ * Find all the RegionKey rows overlapping the specified VariantKey.
+ * The row numbers are returned in ascending order.
+ *
+ * @param rki       Structure containing the pointers to the RegionKey interval index columns.
+ * @param nvc       Structure containing the pointers to the NRVK memory mapped file columns.
+ * @param vk        VariantKey code.
+ * @param rows      Output buffer for the overlapping row numbers.
+ * @param maxrows   Size of the rows buffer. Only the first maxrows results are stored.
+ *
+ * @return Total number of overlapping rows (it can be greater than maxrows).
+ */
+static inline uint64_t find_variantkey_regionkey_overlaps(rkindex_cols_t rki, nrvk_cols_t nvc, uint64_t vk, uint64_t *rows, uint64_t maxrows)
+{
+    return find_region_regionkey_overlaps(rki, extract_variantkey_chrom(vk), extract_variantkey_pos(vk), get_variantkey_endpos(nvc, vk), rows, maxrows);
+}
+
+#endif  // VARIANTKEY_REGIONINDEX_H
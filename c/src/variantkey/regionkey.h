@@ -317,4 +317,271 @@ static inline uint64_t variantkey_to_regionkey(nrvk_cols_t nvc, uint64_t vk)
     return ((vk & VKMASK_CHROMPOS) | ((uint64_t)get_variantkey_endpos(nvc, vk) << RKSHIFT_ENDPOS));
 }
 
+/** @brief Check if a region overlaps each RegionKey of an array.
+ *
+ * @param chrom     Region chromosome code.
+ * @param startpos  Region start position.
+ * @param endpos    Region end position (startpos + region length).
+ * @param rk        Pointer to the first element of the RegionKey array.
+ * @param nitems    Number of elements in the array.
+ * @param res       Pointer to the first element of the output array: 1 if the regions overlap, 0 otherwise.
+ */
+static inline void are_overlapping_region_regionkey_array(uint8_t chrom, uint32_t startpos, uint32_t endpos, const uint64_t *rk, uint64_t nitems, uint8_t *res)
+{
+    uint64_t i = 0;
+    for (i = 0; i < nitems; i++)
+    {
+        res[i] = (uint8_t)((chrom == extract_regionkey_chrom(rk[i])) & (startpos < extract_regionkey_endpos(rk[i])) & (endpos > extract_regionkey_startpos(rk[i])));
+    }
+}
+
+/** @brief Check if each pair of VariantKey and RegionKey of two arrays are overlapping.
+ *
+ * The reversible VariantKeys are processed first in a branchless loop,
+ * then the non-reversible ones are resolved with a single forward pass on the NRVK file
+ * (fastest when the VariantKeys are sorted in ascending order).
+ *
+ * @param nvc      Structure containing the pointers to the NRVK memory mapped file columns.
+ * @param vk       Pointer to the first element of the VariantKey array.
+ * @param rk       Pointer to the first element of the RegionKey array.
+ * @param nitems   Number of elements in the arrays.
+ * @param res      Pointer to the first element of the output array: 1 if the regions overlap, 0 otherwise.
+ */
+static inline void are_overlapping_variantkey_regionkey_array(nrvk_cols_t nvc, const uint64_t *vk, const uint64_t *rk, uint64_t nitems, uint8_t *res)
+{
+    uint64_t i = 0, first = 0;
+    uint32_t endpos = 0;
+    for (i = 0; i < nitems; i++)
+    {
+        res[i] = (uint8_t)((extract_variantkey_chrom(vk[i]) == extract_regionkey_chrom(rk[i])) & (extract_variantkey_pos(vk[i]) < extract_regionkey_endpos(rk[i])) & (get_variantkey_endpos_rev(vk[i]) > extract_regionkey_startpos(rk[i])));
+    }
+    for (i = 0; i < nitems; i++)
+    {
+        if (vk[i] & 0x1)
+        {
+            endpos = (extract_variantkey_pos(vk[i]) + (uint32_t)find_nrvk_ref_length_from(nvc, &first, vk[i]));
+            res[i] = (uint8_t)((extract_variantkey_chrom(vk[i]) == extract_regionkey_chrom(rk[i])) && (extract_variantkey_pos(vk[i]) < extract_regionkey_endpos(rk[i])) && (endpos > extract_regionkey_startpos(rk[i])));
+        }
+    }
+}
+
+/** @brief Get the RegionKeys from an array of VariantKeys.
+ *
+ * The reversible VariantKeys are processed first in a branchless loop,
+ * then the non-reversible ones are resolved with a single forward pass on the NRVK file
+ * (fastest when the VariantKeys are sorted in ascending order).
+ *
+ * @param nvc      Structure containing the pointers to the NRVK memory mapped file columns.
+ * @param vk       Pointer to the first element of the VariantKey array.
+ * @param nitems   Number of elements in the array.
+ * @param rk       Pointer to the first element of the output RegionKey array (it must not overlap the input array).
+ */
+static inline void variantkey_to_regionkey_array(nrvk_cols_t nvc, const uint64_t *vk, uint64_t nitems, uint64_t *rk)
+{
+    uint64_t i = 0, first = 0;
+    for (i = 0; i < nitems; i++)
+    {
+        rk[i] = ((vk[i] & VKMASK_CHROMPOS) | ((uint64_t)get_variantkey_endpos_rev(vk[i]) << RKSHIFT_ENDPOS));
+    }
+    for (i = 0; i < nitems; i++)
+    {
+        if (vk[i] & 0x1)
+        {
+            rk[i] += ((uint64_t)find_nrvk_ref_length_from(nvc, &first, vk[i]) << RKSHIFT_ENDPOS);
+        }
+    }
+}
+
+/**
+ * Struct containing the state of a sorted VariantKey-RegionKey join.
+ */
+typedef struct vkrk_join_t
+{
+    uint64_t *active;  //!< Buffer for the active RegionKey rows, used as a min-heap by CHROM + END POS. It must be sized to contain (rklast - rkfirst) items.
+    uint64_t nactive;  //!< Number of active RegionKey rows.
+    uint64_t vkpos;    //!< Current VariantKey row.
+    uint64_t vklast;   //!< VariantKey row (up to but not including) where to end the join.
+    uint64_t rkpos;    //!< Next RegionKey row to be activated.
+    uint64_t rklast;   //!< RegionKey row (up to but not including) where to end the join.
+    uint64_t vkend;    //!< CHROM + END POS of the current VariantKey.
+    uint64_t scanpos;  //!< Position of the next active row to check against the current VariantKey.
+    uint8_t inscan;    //!< 1 if the scan of the active rows for the current VariantKey is in progress.
+} vkrk_join_t;
+
+/** @brief Find the range of rows containing the specified chromosome in a sorted VariantKey or RegionKey column.
+ *
+ * This can be used to split a join by chromosome and process each part independently (e.g. in parallel).
+ *
+ * @param keys   Pointer to the VariantKey or RegionKey column, sorted in ascending order.
+ * @param nrows  Number of rows.
+ * @param chrom  Chromosome encoded number.
+ * @param first  This will hold the first row containing the chromosome.
+ * @param last   This will hold the row (up to but not including) where the chromosome ends.
+ *
+ * @return Number of rows containing the chromosome.
+ */
+static inline uint64_t find_chrom_rows(const uint64_t *keys, uint64_t nrows, uint8_t chrom, uint64_t *first, uint64_t *last)
+{
+    uint64_t min = 0;
+    uint64_t max = nrows;
+    *first = nrows;
+    if ((nrows > 0) && ((keys[(nrows - 1)] >> RKSHIFT_CHROM) >= chrom))
+    {
+        *first = col_find_first_sub_uint64_t(keys, 0, 4, &min, &max, chrom);
+    }
+    if (*first >= nrows)
+    {
+        *first = *last = 0;
+        return 0;
+    }
+    min = *first;
+    max = nrows;
+    *last = (col_find_last_sub_uint64_t(keys, 0, 4, &min, &max, chrom) + 1);
+    return (*last - *first);
+}
+
+/** @brief Initialize the state of a sorted VariantKey-RegionKey join.
+ *
+ * @param jn       Join state to initialize.
+ * @param active   Buffer for the active RegionKey rows. It must be sized to contain (rklast - rkfirst) items.
+ * @param vkfirst  First VariantKey row to join.
+ * @param vklast   VariantKey row (up to but not including) where to end the join.
+ * @param rkfirst  First RegionKey row to join.
+ * @param rklast   RegionKey row (up to but not including) where to end the join.
+ */
+static inline void init_variantkey_regionkey_join(vkrk_join_t *jn, uint64_t *active, uint64_t vkfirst, uint64_t vklast, uint64_t rkfirst, uint64_t rklast)
+{
+    jn->active = active;
+    jn->nactive = 0;
+    jn->vkpos = vkfirst;
+    jn->vklast = vklast;
+    jn->rkpos = rkfirst;
+    jn->rklast = rklast;
+    jn->vkend = 0;
+    jn->scanpos = 0;
+    jn->inscan = 0;
+}
+
+/**
+ * Restore the min-heap property of the active RegionKey rows moving down the specified item.
+ *
+ * @param rk   Pointer to the RegionKey column.
+ * @param jn   Join state.
+ * @param pos  Position of the item to move.
+ */
+static inline void sift_down_vkrk_join(const uint64_t *rk, vkrk_join_t *jn, uint64_t pos)
+{
+    uint64_t *h = jn->active;
+    uint64_t item = h[pos];
+    uint64_t end = get_regionkey_chrom_endpos(rk[item]);
+    uint64_t child = 0;
+    while ((child = ((pos << 1) + 1)) < jn->nactive)
+    {
+        if (((child + 1) < jn->nactive) && (get_regionkey_chrom_endpos(rk[h[(child + 1)]]) < get_regionkey_chrom_endpos(rk[h[child]])))
+        {
+            child++;
+        }
+        if (get_regionkey_chrom_endpos(rk[h[child]]) >= end)
+        {
+            break;
+        }
+        h[pos] = h[child];
+        pos = child;
+    }
+    h[pos] = item;
+}
+
+/**
+ * Add a RegionKey row to the active min-heap.
+ *
+ * @param rk   Pointer to the RegionKey column.
+ * @param jn   Join state.
+ * @param row  RegionKey row to add.
+ */
+static inline void push_vkrk_join(const uint64_t *rk, vkrk_join_t *jn, uint64_t row)
+{
+    uint64_t *h = jn->active;
+    uint64_t end = get_regionkey_chrom_endpos(rk[row]);
+    uint64_t pos = jn->nactive++;
+    uint64_t parent = 0;
+    while (pos > 0)
+    {
+        parent = ((pos - 1) >> 1);
+        if (get_regionkey_chrom_endpos(rk[h[parent]]) <= end)
+        {
+            break;
+        }
+        h[pos] = h[parent];
+        pos = parent;
+    }
+    h[pos] = row;
+}
+
+/** @brief Join a sorted VariantKey column with a sorted RegionKey column.
+ *
+ * Returns the (VariantKey row, RegionKey row) pairs of overlapping items using a single linear sweep.
+ * The RegionKeys that may overlap the current VariantKey are kept in a min-heap ordered by end position,
+ * so nested and long regions are supported.
+ * This function can be called repeatedly to stream the results in chunks of maxpairs pairs,
+ * until it returns 0 (or jn->vkpos == jn->vklast).
+ * The pairs are returned in VariantKey row order.
+ *
+ * @param nvc       Structure containing the pointers to the NRVK memory mapped file columns.
+ * @param vk        Pointer to the VariantKey column, sorted in ascending order.
+ * @param rk        Pointer to the RegionKey column, sorted in ascending order.
+ * @param jn        Join state (see init_variantkey_regionkey_join).
+ * @param vkrows    Output buffer for the VariantKey rows.
+ * @param rkrows    Output buffer for the RegionKey rows.
+ * @param maxpairs  Size of the output buffers.
+ *
+ * @return Number of returned pairs.
+ */
+static inline uint64_t join_variantkey_regionkey(nrvk_cols_t nvc, const uint64_t *vk, const uint64_t *rk, vkrk_join_t *jn, uint64_t *vkrows, uint64_t *rkrows, uint64_t maxpairs)
+{
+    uint64_t n = 0, vkstart = 0, row = 0;
+    while (jn->vkpos < jn->vklast)
+    {
+        if (jn->inscan == 0)
+        {
+            vkstart = get_variantkey_chrom_startpos(vk[jn->vkpos]);
+            jn->vkend = get_variantkey_chrom_endpos(nvc, vk[jn->vkpos]);
+            // retire the regions ending before the current variant (the variant start positions are sorted)
+            while ((jn->nactive > 0) && (get_regionkey_chrom_endpos(rk[jn->active[0]]) <= vkstart))
+            {
+                jn->active[0] = jn->active[--jn->nactive];
+                sift_down_vkrk_join(rk, jn, 0);
+            }
+            // activate the regions starting before the current variant end
+            while ((jn->rkpos < jn->rklast) && (get_regionkey_chrom_startpos(rk[jn->rkpos]) < jn->vkend))
+            {
+                if (get_regionkey_chrom_endpos(rk[jn->rkpos]) > vkstart)
+                {
+                    push_vkrk_join(rk, jn, jn->rkpos);
+                }
+                jn->rkpos++;
+            }
+            jn->scanpos = 0;
+            jn->inscan = 1;
+        }
+        while (jn->scanpos < jn->nactive)
+        {
+            row = jn->active[jn->scanpos];
+            if (get_regionkey_chrom_startpos(rk[row]) < jn->vkend)
+            {
+                if (n >= maxpairs)
+                {
+                    return n;
+                }
+                vkrows[n] = jn->vkpos;
+                rkrows[n] = row;
+                n++;
+            }
+            jn->scanpos++;
+        }
+        jn->inscan = 0;
+        jn->vkpos++;
+    }
+    return n;
+}
+
 #endif  // VARIANTKEY_REGIONKEY_H
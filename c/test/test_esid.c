@@ -326,6 +326,201 @@ void benchmark_hash_string_id()
     (void) fprintf(stdout, " * %s : %lu ns/op (%" PRIx64 ")\n", __func__, (tend - tstart)/size, hsid);
 }
 
+enum
+{
+    TEST_ESID_ARRAY_SIZE = 1000
+};
+
+static char test_esid_str[(TEST_ESID_ARRAY_SIZE * 12)];
+static char test_esid_dec[(TEST_ESID_ARRAY_SIZE * ESID_MAXDECLEN)];
+static uint64_t test_esid_offset[(TEST_ESID_ARRAY_SIZE + 1)];
+static uint64_t test_esid_decoffset[(TEST_ESID_ARRAY_SIZE + 1)];
+static uint64_t test_esid_code[TEST_ESID_ARRAY_SIZE];
+
+// simple deterministic pseudo-random number generator
+uint32_t test_rand(uint64_t *seed)
+{
+    *seed = ((*seed * 6364136223846793005ULL) + 1442695040888963407ULL);
+    return (uint32_t)(*seed >> 33);
+}
+
+// generate random strings with 0 to 12 characters, including non-printable and non-ASCII bytes
+void init_test_esid_str()
+{
+    uint64_t seed = 11;
+    uint64_t pos = 0;
+    int i = 0, j = 0, len = 0;
+    for (i = 0; i < TEST_ESID_ARRAY_SIZE; i++)
+    {
+        test_esid_offset[i] = pos;
+        len = (int)(test_rand(&seed) % 13);
+        for (j = 0; j < len; j++)
+        {
+            test_esid_str[pos++] = (char)(((i % 10) == 0) ? (1 + (test_rand(&seed) % 255)) : ('!' + (test_rand(&seed) % 90)));
+        }
+    }
+    test_esid_offset[TEST_ESID_ARRAY_SIZE] = pos;
+}
+
+int test_encode_string_id_array()
+{
+    int errors = 0;
+    uint64_t offset[2] = {0};
+    uint64_t esid = 0;
+    int i = 0;
+    for (i = 0; i < k_esid_data_size; i++)
+    {
+        offset[0] = esid_data[i].start;
+        offset[1] = esid_data[i].size;
+        encode_string_id_array(esid_data[i].str, offset, 1, &esid);
+        if (esid != esid_data[i].esid)
+        {
+            (void) fprintf(stderr, "%s (%d): Expected 0x%016" PRIx64 ", got 0x%016" PRIx64 "\n", __func__, i, esid_data[i].esid, esid);
+            ++errors;
+        }
+    }
+    encode_string_id_array(test_esid_str, test_esid_offset, TEST_ESID_ARRAY_SIZE, test_esid_code);
+    for (i = 0; i < TEST_ESID_ARRAY_SIZE; i++)
+    {
+        esid = encode_string_id((test_esid_str + test_esid_offset[i]), (size_t)(test_esid_offset[(i + 1)] - test_esid_offset[i]), 0);
+        if (test_esid_code[i] != esid)
+        {
+            (void) fprintf(stderr, "%s (%d): Expected 0x%016" PRIx64 ", got 0x%016" PRIx64 "\n", __func__, i, esid, test_esid_code[i]);
+            ++errors;
+        }
+    }
+    return errors;
+}
+
+int test_decode_string_id_array()
+{
+    int errors = 0;
+    char str[ESID_MAXDECLEN];
+    uint64_t len = 0, pos = 0;
+    size_t size = 0;
+    int i = 0;
+    for (i = 0; i < TEST_ESID_ARRAY_SIZE; i += 3)
+    {
+        // include some string IDs with a number
+        test_esid_code[i] = encode_string_num_id((test_esid_str + test_esid_offset[i]), (size_t)(test_esid_offset[(i + 1)] - test_esid_offset[i]), ':');
+    }
+    test_esid_code[1] = encode_string_num_id("ABCDE:0000000134217727", 22, ':'); // maximum decoded size
+    len = decode_string_id_array(test_esid_code, TEST_ESID_ARRAY_SIZE, test_esid_dec, test_esid_decoffset);
+    for (i = 0; i < TEST_ESID_ARRAY_SIZE; i++)
+    {
+        size = decode_string_id(test_esid_code[i], str);
+        if ((test_esid_decoffset[i] != pos) || ((test_esid_decoffset[(i + 1)] - pos) != size) || (memcmp((test_esid_dec + pos), str, size) != 0))
+        {
+            (void) fprintf(stderr, "%s (%d): Expected %s, got %.*s\n", __func__, i, str, (int)(test_esid_decoffset[(i + 1)] - test_esid_decoffset[i]), (test_esid_dec + test_esid_decoffset[i]));
+            ++errors;
+        }
+        pos += size;
+    }
+    if (len != pos)
+    {
+        (void) fprintf(stderr, "%s : Expected %" PRIu64 " characters, got %" PRIu64 "\n", __func__, pos, len);
+        ++errors;
+    }
+    return errors;
+}
+
+void benchmark_encode_string_id_array()
+{
+    uint64_t tstart = 0, tend = 0;
+    int i = 0;
+    int size = 100;
+    tstart = get_time();
+    for (i = 0; i < size; i++)
+    {
+        encode_string_id_array(test_esid_str, test_esid_offset, TEST_ESID_ARRAY_SIZE, test_esid_code);
+    }
+    tend = get_time();
+    (void) fprintf(stdout, " * %s : %lu ns/op (%" PRIx64 ")\n", __func__, (tend - tstart)/(size * TEST_ESID_ARRAY_SIZE), test_esid_code[0]);
+}
+
+void benchmark_decode_string_id_array()
+{
+    uint64_t tstart = 0, tend = 0;
+    uint64_t len = 0;
+    int i = 0;
+    int size = 100;
+    tstart = get_time();
+    for (i = 0; i < size; i++)
+    {
+        len += decode_string_id_array(test_esid_code, TEST_ESID_ARRAY_SIZE, test_esid_dec, test_esid_decoffset);
+    }
+    tend = get_time();
+    (void) fprintf(stdout, " * %s : %lu ns/op (%" PRIu64 ")\n", __func__, (tend - tstart)/(size * TEST_ESID_ARRAY_SIZE), len);
+}
+
+int test_hash_string_id_array()
+{
+    int errors = 0;
+    static char data[(TEST_ESID_ARRAY_SIZE * 40)];
+    static uint64_t offset[(TEST_ESID_ARRAY_SIZE + 1)];
+    static uint64_t hsid[TEST_ESID_ARRAY_SIZE];
+    uint64_t seed = 13;
+    uint64_t pos = 0, h = 0;
+    int i = 0, j = 0, len = 0;
+    for (i = 0; i < k_esid_data_size; i++)
+    {
+        offset[0] = 0;
+        offset[1] = esid_data[i].size;
+        hash_string_id_array(esid_data[i].str, offset, 1, &h);
+        if (h != esid_data[i].hsid)
+        {
+            (void) fprintf(stderr, "%s (%d): Expected 0x%016" PRIx64 ", got 0x%016" PRIx64 "\n", __func__, i, esid_data[i].hsid, h);
+            ++errors;
+        }
+    }
+    // random strings with 0 to 39 bytes (unaligned)
+    for (i = 0; i < TEST_ESID_ARRAY_SIZE; i++)
+    {
+        offset[i] = pos;
+        len = (int)(test_rand(&seed) % 40);
+        for (j = 0; j < len; j++)
+        {
+            data[pos++] = (char)(test_rand(&seed) % 256);
+        }
+    }
+    offset[TEST_ESID_ARRAY_SIZE] = pos;
+    hash_string_id_array(data, offset, (TEST_ESID_ARRAY_SIZE - 1), hsid);
+    for (i = 0; i < (TEST_ESID_ARRAY_SIZE - 1); i++)
+    {
+        h = hash_string_id((data + offset[i]), (size_t)(offset[(i + 1)] - offset[i]));
+        if (hsid[i] != h)
+        {
+            (void) fprintf(stderr, "%s (%d): Expected 0x%016" PRIx64 ", got 0x%016" PRIx64 "\n", __func__, i, h, hsid[i]);
+            ++errors;
+        }
+    }
+    return errors;
+}
+
+void benchmark_hash_string_id_array()
+{
+    static char data[(TEST_ESID_ARRAY_SIZE * 36)];
+    static uint64_t offset[(TEST_ESID_ARRAY_SIZE + 1)];
+    static uint64_t hsid[TEST_ESID_ARRAY_SIZE];
+    uint64_t tstart = 0, tend = 0;
+    int i = 0;
+    int size = 100;
+    for (i = 0; i < TEST_ESID_ARRAY_SIZE; i++)
+    {
+        memcpy((data + (i * 36)), "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ", 36);
+        data[(i * 36)] = (char)('A' + (i % 26));
+        offset[i] = (uint64_t)(i * 36);
+    }
+    offset[TEST_ESID_ARRAY_SIZE] = (TEST_ESID_ARRAY_SIZE * 36);
+    tstart = get_time();
+    for (i = 0; i < size; i++)
+    {
+        hash_string_id_array(data, offset, TEST_ESID_ARRAY_SIZE, hsid);
+    }
+    tend = get_time();
+    (void) fprintf(stdout, " * %s : %lu ns/op (%" PRIx64 ")\n", __func__, (tend - tstart)/(size * TEST_ESID_ARRAY_SIZE), hsid[0]);
+}
+
 int main()
 {
     int errors = 0;
@@ -336,11 +531,19 @@ int main()
     errors += test_decode_string_num_id();
     errors += test_hash_string_id();
 
+    init_test_esid_str();
+    errors += test_encode_string_id_array();
+    errors += test_decode_string_id_array();
+    errors += test_hash_string_id_array();
+
     benchmark_encode_string_id();
     benchmark_encode_string_num_id();
     benchmark_decode_string_id();
     benchmark_decode_string_num_id();
     benchmark_hash_string_id();
+    benchmark_encode_string_id_array();
+    benchmark_decode_string_id_array();
+    benchmark_hash_string_id_array();
 
     return errors;
 }
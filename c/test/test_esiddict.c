@@ -0,0 +1,248 @@
+// VariantKey
+//
+// test_esiddict.c
+//
+// @category   Test
+// @author     Nicola Asuni <info@tecnick.com>
+// @link       https://github.com/tecnickcom/variantkey
+// @license    MIT [LICENSE](https://raw.githubusercontent.com/tecnickcom/variantkey/main/LICENSE)
+
+// Test for esiddict
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "../src/variantkey/esiddict.h"
+
+enum
+{
+    TEST_DICT_SIZE = 1000,
+    TEST_DICT_DATA_SIZE = (TEST_DICT_SIZE * 24),
+    TEST_DICT_NBUCKETS = ((TEST_DICT_SIZE + ESIDDICT_MPH_LAMBDA - 1) / ESIDDICT_MPH_LAMBDA)
+};
+
+static char test_data[TEST_DICT_DATA_SIZE];
+static uint64_t test_offset[(TEST_DICT_SIZE + 1)];
+static uint64_t test_esid[TEST_DICT_SIZE];
+static uint64_t test_tmp[TEST_DICT_SIZE];
+static uint32_t test_idx[TEST_DICT_SIZE];
+static uint32_t test_tdx[TEST_DICT_SIZE];
+static char test_ddata[TEST_DICT_DATA_SIZE];
+static uint64_t test_doffset[(TEST_DICT_SIZE + 1)];
+static uint32_t test_disp[TEST_DICT_NBUCKETS];
+static uint32_t test_row[TEST_DICT_SIZE];
+static uint32_t test_mphtmp[((2 * TEST_DICT_NBUCKETS) + 1 + TEST_DICT_SIZE)];
+
+// returns current time in nanoseconds
+uint64_t get_time()
+{
+    struct timespec t;
+    (void) timespec_get(&t, TIME_UTC);
+    return (((uint64_t)t.tv_sec * 1000000000) + (uint64_t)t.tv_nsec);
+}
+
+// encode short string IDs and hash the long ones
+uint64_t test_string_esid(const char *str, size_t size)
+{
+    if (size > ESID_MAXLEN)
+    {
+        return hash_string_id(str, size);
+    }
+    return encode_string_id(str, size, 0);
+}
+
+// generate a mix of short (reversible) and long (hashed) string IDs
+void init_test_dict()
+{
+    uint64_t pos = 0;
+    int i = 0;
+    for (i = 0; i < TEST_DICT_SIZE; i++)
+    {
+        test_offset[i] = pos;
+        if ((i % 3) == 0)
+        {
+            pos += (uint64_t)sprintf((test_data + pos), "ID%05d", i);
+        }
+        else
+        {
+            pos += (uint64_t)sprintf((test_data + pos), "SAMPLE-%06d-BARCODE", i);
+        }
+        test_esid[i] = test_string_esid((test_data + test_offset[i]), (size_t)(pos - test_offset[i]));
+    }
+    test_offset[TEST_DICT_SIZE] = pos;
+}
+
+int check_esiddict(esiddict_cols_t edc, const char *func)
+{
+    int errors = 0;
+    const char *str = NULL;
+    size_t len = 0, explen = 0;
+    uint64_t esid = 0;
+    int i = 0;
+    for (i = 0; i < TEST_DICT_SIZE; i++)
+    {
+        explen = (size_t)(test_offset[(i + 1)] - test_offset[i]);
+        esid = test_string_esid((test_data + test_offset[i]), explen);
+        len = find_string_by_esid(edc, esid, &str);
+        if ((len != explen) || (str == NULL) || (memcmp(str, (test_data + test_offset[i]), len) != 0))
+        {
+            (void) fprintf(stderr, "%s (%d): Expected %.*s, got %.*s\n", func, i, (int)explen, (test_data + test_offset[i]), (int)len, str);
+            ++errors;
+        }
+    }
+    static const char *missing[3] = {"MISSING", "SAMPLE-999999-BARCODE", "~~~~~~~~~~"};
+    for (i = 0; i < 3; i++)
+    {
+        len = find_string_by_esid(edc, test_string_esid(missing[i], strlen(missing[i])), &str);
+        if ((len != 0) || (str != NULL))
+        {
+            (void) fprintf(stderr, "%s (%d): Expected not found, got %.*s\n", func, i, (int)len, str);
+            ++errors;
+        }
+    }
+    return errors;
+}
+
+int test_build_esiddict_mph()
+{
+    int errors = 0;
+    static const uint64_t esid[8] = {1, 2, 3, 5, 8, 13, 21, 34};
+    uint32_t disp[2] = {0};
+    uint32_t row[8] = {0};
+    uint32_t tmp[13] = {0};
+    esiddict_cols_t edc = {0};
+    uint64_t nrows = 0, i = 0, r = 0;
+    edc.esid = esid;
+    edc.disp = disp;
+    edc.row = row;
+    for (nrows = 0; nrows <= 8; nrows++)
+    {
+        if (build_esiddict_mph(esid, nrows, disp, row, tmp) != 0)
+        {
+            (void) fprintf(stderr, "%s (%" PRIu64 "): Unexpected error\n", __func__, nrows);
+            ++errors;
+            continue;
+        }
+        edc.nrows = nrows;
+        edc.nbuckets = get_esiddict_mph_nbuckets(nrows);
+        for (i = 0; i < nrows; i++)
+        {
+            r = find_esiddict_row(edc, esid[i]);
+            if (r != i)
+            {
+                (void) fprintf(stderr, "%s (%" PRIu64 " %" PRIu64 "): Expected row %" PRIu64 ", got %" PRIu64 "\n", __func__, nrows, i, i, r);
+                ++errors;
+            }
+        }
+        r = find_esiddict_row(edc, 4);
+        if (r != nrows)
+        {
+            (void) fprintf(stderr, "%s (%" PRIu64 "): Expected not found, got %" PRIu64 "\n", __func__, nrows, r);
+            ++errors;
+        }
+    }
+    static const uint64_t dup[3] = {1, 2, 2};
+    if (build_esiddict_mph(dup, 3, disp, row, tmp) != 1)
+    {
+        (void) fprintf(stderr, "%s : Expected error for duplicate keys\n", __func__);
+        ++errors;
+    }
+    return errors;
+}
+
+int test_esiddict_file(const char *file, int mph, size_t explen)
+{
+    int errors = 0;
+    size_t len = write_esiddict_file(file, test_esid, test_doffset, test_ddata, TEST_DICT_SIZE, (mph ? test_disp : NULL), (mph ? test_row : NULL));
+    if (len != explen)
+    {
+        (void) fprintf(stderr, "%s (%s): Expecting file with %lu bytes, got %lu\n", __func__, file, explen, len);
+        return 1;
+    }
+    mmfile_t mf = {0};
+    esiddict_cols_t edc = {0};
+    mmap_esiddict_file(file, &mf, &edc);
+    if ((edc.nrows != TEST_DICT_SIZE) || ((edc.disp != NULL) != mph))
+    {
+        (void) fprintf(stderr, "%s (%s): Expecting %d items, got instead: %" PRIu64 "\n", __func__, file, TEST_DICT_SIZE, edc.nrows);
+        return 1;
+    }
+    errors += check_esiddict(edc, __func__);
+    int err = munmap_binfile(mf);
+    if (err != 0)
+    {
+        (void) fprintf(stderr, "%s (%s): Got %d error while unmapping the file\n", __func__, file, err);
+        ++errors;
+    }
+    return errors;
+}
+
+int test_esiddict()
+{
+    int errors = 0;
+    build_esiddict(test_esid, test_tmp, test_idx, test_tdx, test_data, test_offset, TEST_DICT_SIZE, test_doffset, test_ddata);
+    if (build_esiddict_mph(test_esid, TEST_DICT_SIZE, test_disp, test_row, test_mphtmp) != 0)
+    {
+        (void) fprintf(stderr, "%s : Unable to build the hash index\n", __func__);
+        return 1;
+    }
+    errors += test_esiddict_file("esiddict.test.bin", 1, 35872);
+    errors += test_esiddict_file("esiddict_nomph.test.bin", 0, 30864);
+    return errors;
+}
+
+int test_write_esiddict_file_error()
+{
+    int errors = 0;
+    size_t len = write_esiddict_file("/WRONG/../../esiddict.test.bin", test_esid, test_doffset, test_ddata, TEST_DICT_SIZE, NULL, NULL);
+    if (len != 0)
+    {
+        (void) fprintf(stderr, "%s Expecting 0 bytes, got %lu\n", __func__, len);
+        ++errors;
+    }
+    return errors;
+}
+
+void benchmark_find_esiddict_row(int mph)
+{
+    esiddict_cols_t edc = {0};
+    edc.esid = test_esid;
+    edc.offset = test_doffset;
+    edc.data = test_ddata;
+    edc.nrows = TEST_DICT_SIZE;
+    edc.nbuckets = TEST_DICT_NBUCKETS;
+    if (mph)
+    {
+        edc.disp = test_disp;
+        edc.row = test_row;
+    }
+    uint64_t tstart = 0, tend = 0;
+    uint64_t sum = 0;
+    int i = 0;
+    int size = 100000;
+    tstart = get_time();
+    for (i = 0; i < size; i++)
+    {
+        sum += find_esiddict_row(edc, test_esid[(i % TEST_DICT_SIZE)]);
+    }
+    tend = get_time();
+    (void) fprintf(stdout, " * %s (mph: %d) : %lu ns/op (%" PRIu64 ")\n", __func__, mph, (tend - tstart)/size, sum);
+}
+
+int main()
+{
+    int errors = 0;
+
+    init_test_dict();
+
+    errors += test_build_esiddict_mph();
+    errors += test_esiddict();
+    errors += test_write_esiddict_file_error();
+
+    benchmark_find_esiddict_row(0);
+    benchmark_find_esiddict_row(1);
+
+    return errors;
+}
@@ -249,6 +249,56 @@ int test_check_reference(mmfile_t mf)
     return errors;
 }
 
+int test_check_reference_seq()
+{
+    int errors = 0;
+    int ret = 0;
+    int i = 0;
+    typedef struct test_seq_t
+    {
+        int        exp;
+        const char *gseq;
+        const char *ref;
+    } test_seq_t;
+    static test_seq_t test_seq[8] =
+    {
+        { 0, "ACGTACGTACGTACGTACGTA", "ACGTACGTACGTACGTACGTA"},
+        { 0, "ACGTACGTACGTACGTACGTA", "acgtACGTacgtACGTacgta"},
+        { 1, "ACGTACGTACGTACGTACGTA", "ACGTACGTACGTACNTACGTA"},
+        { 1, "ACGTACGTACGTACGTACGTA", "ACGTACGTACGTACGTACGTN"},
+        { 1, "ACGTACGTACGTRCGTACGTA", "ACGTACGTACGTACGTACGTA"},
+        {-1, "ACGTACGTACGTACGTACGTA", "ACGTACGTACGTACGTACGTC"},
+        {-1, "ACGTACGTACGTACGTACGTA", "ACGTACGTANGTACGTAWGTA"},
+        {-1, "ACGTACGTACGTACGTACGTA", "ACGTACG\xe1" "ACGTACGTACGTA"},
+    };
+    for (i = 0; i < 8; i++)
+    {
+        ret = check_reference_seq(test_seq[i].gseq, test_seq[i].ref, strlen(test_seq[i].ref));
+        if (ret != test_seq[i].exp)
+        {
+            (void) fprintf(stderr, "%s (%d): Expected %d, got %d\n", __func__, i, test_seq[i].exp, ret);
+            ++errors;
+        }
+    }
+    return errors;
+}
+
+void benchmark_check_reference_seq()
+{
+    const char *gseq = "ACGTACGTACGTACGTACGTACGTACGTACGTACGTACGTACGTACGTACGTACGTACGTACGT";
+    const char *ref = "acgtacgtACGTACGTacgtacgtACGTACGTacgtacgtACGTACGTacgtacgtACGTACGN";
+    uint64_t tstart = 0, tend = 0;
+    int i = 0, sum = 0;
+    int size = 100000;
+    tstart = get_time();
+    for (i=0 ; i < size; i++)
+    {
+        sum += check_reference_seq(gseq, ref, 64);
+    }
+    tend = get_time();
+    (void) fprintf(stdout, " * %s : %lu ns/op (%d)\n", __func__, (tend - tstart)/(uint64_t)size, sum);
+}
+
 int test_flip_allele()
 {
     int errors = 0;
@@ -263,6 +313,48 @@ int test_flip_allele()
     return errors;
 }
 
+int test_complement_allele()
+{
+    int errors = 0;
+    const char allele[] = "ATCGMKRYBVDHWSNatcgmkrybvdhwsn";
+    const char expected[] = "TAGCKMYRVBHDWSNTAGCKMYRVBHDWSN";
+    char out[32] = {0};
+    complement_allele(out, allele, 30);
+    if (strcmp(out, expected) != 0)
+    {
+        (void) fprintf(stderr, "%s : Expected %s, got %s\n", __func__, expected, out);
+        ++errors;
+    }
+    complement_allele(out, allele, 0);
+    if (out[0] != 0)
+    {
+        (void) fprintf(stderr, "%s : Expected empty string, got %s\n", __func__, out);
+        ++errors;
+    }
+    return errors;
+}
+
+int test_reverse_complement_allele()
+{
+    int errors = 0;
+    static const char *allele[5] = {"", "a", "AC", "ACGTN", "AAACCCGGGTTTmk"};
+    static const char *expected[5] = {"", "T", "GT", "NACGT", "MKAAACCCGGGTTT"};
+    char out[16] = {0};
+    int i = 0;
+    for (i = 0; i < 5; i++)
+    {
+        size_t size = strlen(allele[i]);
+        memcpy(out, allele[i], size);
+        reverse_complement_allele(out, size);
+        if (strcmp(out, expected[i]) != 0)
+        {
+            (void) fprintf(stderr, "%s (%d): Expected %s, got %s\n", __func__, i, expected[i], out);
+            ++errors;
+        }
+    }
+    return errors;
+}
+
 void benchmark_flip_allele()
 {
     char allele[] =   "ATCGMKRYBVDHWSNatcgmkrybvdhwsn";
@@ -431,6 +523,222 @@ int test_normalized_variantkey(mmfile_t mf)
     return errors;
 }
 
+int test_normalize_variant_batch(mmfile_t mf)
+{
+    enum { TEST_BATCH_SIZE = 300 };
+    static const char *alleles[6] = {"A", "C", "GT", "TTA", "N", "AC"};
+    static normvar_t var[TEST_BATCH_SIZE], exp[TEST_BATCH_SIZE];
+    static uint64_t key[TEST_BATCH_SIZE], tmp[TEST_BATCH_SIZE];
+    static uint32_t idx[TEST_BATCH_SIZE], tdx[TEST_BATCH_SIZE];
+    int errors = 0;
+    uint32_t i = 0, len = 0;
+    uint64_t seed = 11;
+    for (i = 0; i < TEST_BATCH_SIZE; i++)
+    {
+        seed = ((seed * 6364136223846793005ULL) + 1442695040888963407ULL);
+        var[i].chrom = (uint8_t)(1 + ((seed >> 33) % 25));
+        len = (uint32_t)(mf.index[(var[i].chrom + 1)] - mf.index[var[i].chrom]);
+        var[i].pos = (uint32_t)(1 + ((seed >> 40) % (len - 1)));
+        var[i].sizeref = (((seed >> 20) % 3) == 0) ? strlen(alleles[((seed >> 24) % 6)]) : 1;
+        if ((var[i].pos + var[i].sizeref) > len)
+        {
+            var[i].sizeref = 1;
+        }
+        if (((seed >> 20) % 3) == 0)
+        {
+            strcpy(var[i].ref, alleles[((seed >> 24) % 6)]);
+        }
+        else
+        {
+            var[i].ref[0] = get_genoref_seq(mf, var[i].chrom, var[i].pos);
+            var[i].ref[1] = 0;
+        }
+        strcpy(var[i].alt, alleles[((seed >> 28) % 6)]);
+        var[i].sizealt = strlen(var[i].alt);
+        exp[i] = var[i];
+        exp[i].status = normalize_variant(mf, exp[i].chrom, &exp[i].pos, exp[i].ref, &exp[i].sizeref, exp[i].alt, &exp[i].sizealt);
+    }
+    normalize_variant_batch(mf, var, TEST_BATCH_SIZE, key, tmp, idx, tdx);
+    for (i = 0; i < TEST_BATCH_SIZE; i++)
+    {
+        if ((var[i].status != exp[i].status) || (var[i].pos != exp[i].pos) || (var[i].sizeref != exp[i].sizeref) || (var[i].sizealt != exp[i].sizealt)
+                || (strcmp(var[i].ref, exp[i].ref) != 0) || (strcmp(var[i].alt, exp[i].alt) != 0))
+        {
+            (void) fprintf(stderr, "%s (%" PRIu32 "): Expected %d %" PRIu32 " %s %s, got %d %" PRIu32 " %s %s\n", __func__, i, exp[i].status, exp[i].pos, exp[i].ref, exp[i].alt, var[i].status, var[i].pos, var[i].ref, var[i].alt);
+            ++errors;
+        }
+    }
+    return errors;
+}
+
+// compare the results of the original and packed genoref files
+int compare_genoref_packed(mmfile_t mf, mmfile_t pmf, const char *func)
+{
+    static const char *alleles[8] = {"A", "C", "G", "T", "N", "AC", "", "TTA"};
+    int errors = 0;
+    uint8_t chrom = 0;
+    uint32_t pos = 0, ppos = 0, npos = 0;
+    size_t size = 0, sizeref = 0, sizealt = 0, psizeref = 0, psizealt = 0;
+    int a = 0, b = 0, ret = 0, pret = 0;
+    char ref[ALLELE_MAXSIZE], alt[ALLELE_MAXSIZE], pref[ALLELE_MAXSIZE], palt[ALLELE_MAXSIZE];
+    for (chrom = 1; chrom <= 25; chrom++)
+    {
+        npos = (uint32_t)(mf.index[(chrom + 1)] - mf.index[chrom]);
+        for (pos = 0; pos <= (npos + 1); pos++)
+        {
+            if (get_genoref_seq(mf, chrom, pos) != get_genoref_seq(pmf, chrom, pos))
+            {
+                (void) fprintf(stderr, "%s (%" PRIu8 ":%" PRIu32 "): Different reference\n", func, chrom, pos);
+                ++errors;
+            }
+            for (size = 1; ((pos + size) <= npos) && (size <= 5); size++)
+            {
+                memcpy(ref, (mf.src + mf.index[chrom] + pos), size);
+                ref[(size - 1)] = 'C';
+                if (check_reference(mf, chrom, pos, ref, size) != check_reference(pmf, chrom, pos, ref, size))
+                {
+                    (void) fprintf(stderr, "%s (%" PRIu8 ":%" PRIu32 ":%lu): Different check_reference result\n", func, chrom, pos, size);
+                    ++errors;
+                }
+            }
+            for (a = 0; a < 8; a++)
+            {
+                for (b = 0; b < 8; b++)
+                {
+                    sizeref = psizeref = strlen(alleles[a]);
+                    sizealt = psizealt = strlen(alleles[b]);
+                    if ((pos == 0) && ((sizeref == 0) || (sizealt == 0)))
+                    {
+                        continue; // empty alleles can't be left extended
+                    }
+                    strcpy(ref, alleles[a]);
+                    strcpy(pref, alleles[a]);
+                    strcpy(alt, alleles[b]);
+                    strcpy(palt, alleles[b]);
+                    npos = ppos = pos;
+                    ret = normalize_variant(mf, chrom, &npos, ref, &sizeref, alt, &sizealt);
+                    pret = normalize_variant(pmf, chrom, &ppos, pref, &psizeref, palt, &psizealt);
+                    if ((ret != pret) || ((ret >= 0) && ((npos != ppos) || (strcmp(ref, pref) != 0) || (strcmp(alt, palt) != 0))))
+                    {
+                        (void) fprintf(stderr, "%s (%" PRIu8 ":%" PRIu32 ":%d:%d): Different normalize_variant result\n", func, chrom, pos, a, b);
+                        ++errors;
+                    }
+                }
+            }
+            npos = (uint32_t)(mf.index[(chrom + 1)] - mf.index[chrom]);
+        }
+    }
+    return errors;
+}
+
+int check_genoref_packed_file(mmfile_t mf, const char *file, const char *func)
+{
+    int errors = 0;
+    uint64_t nexc = 0, nlow = 0;
+    uint64_t nbases = (mf.index[26] - mf.index[1]);
+    pack_genoref(mf, NULL, NULL, NULL, NULL, NULL, NULL, &nexc, &nlow);
+    uint8_t packed[((nbases + 3) / 4)];
+    uint64_t excstart[(nexc + 1)], excend[(nexc + 1)], lowstart[(nlow + 1)], lowend[(nlow + 1)];
+    uint8_t excchar[(nexc + 1)];
+    size_t len = write_genoref_packed_file(mf, file, packed, excstart, excend, excchar, lowstart, lowend);
+    if (len == 0)
+    {
+        (void) fprintf(stderr, "%s Unable to write the packed file %s\n", func, file);
+        return 1;
+    }
+    mmfile_t pmf = {0};
+    mmap_genoref_file(file, &pmf);
+    if ((pmf.ncols != GENOREF_PACKED_NCOLS) || (pmf.index[GENOREF_IDX_NEXC] != nexc) || (pmf.index[GENOREF_IDX_NLOW] != nlow))
+    {
+        (void) fprintf(stderr, "%s Invalid packed file %s\n", func, file);
+        return 1;
+    }
+    errors += compare_genoref_packed(mf, pmf, func);
+    if (write_genoref_packed_file(pmf, file, packed, excstart, excend, excchar, lowstart, lowend) != 0)
+    {
+        (void) fprintf(stderr, "%s Expecting 0 bytes from a packed source\n", func);
+        ++errors;
+    }
+    int err = munmap_binfile(pmf);
+    if (err != 0)
+    {
+        (void) fprintf(stderr, "%s Got %d error while unmapping the file\n", func, err);
+        ++errors;
+    }
+    return errors;
+}
+
+int test_genoref_packed_file(mmfile_t mf)
+{
+    int errors = check_genoref_packed_file(mf, "genoref_packed.test.bin", __func__);
+    mmfile_t pmf = {0};
+    mmap_genoref_file("genoref_packed.test.bin", &pmf);
+    if (pmf.size != 5048)
+    {
+        (void) fprintf(stderr, "%s Expecting file with 5048 bytes, got %" PRIu64 "\n", __func__, pmf.size);
+        ++errors;
+    }
+    errors += test_get_genoref_seq(pmf);
+    errors += test_check_reference(pmf);
+    (void) munmap_binfile(pmf);
+    return errors;
+}
+
+int test_genoref_packed_file_lowercase()
+{
+    // chromosomes with mixed case ACGT bases, N runs and IUPAC codes
+    static const char seq[25][17] =
+    {
+        "ACGTACGTACGTACGT", "acgtacgtacgtacgt", "NNNNNNNNNNNNNNNN", "nnnnNNNNacgtACGT", "ACGTnnnnACGTRYKM",
+        "TTTTTTTTTTTTTTTT", "ACGTACGTNACGTACG", "ggggCCCCaaaaTTTT", "AaCcGgTtNnRrYyAA", "ACGTACGTACGTACGa",
+        "NACGTACGTACGTACG", "ACGTACGTACGTACGN", "ACGTACGTRRRRACGT", "AAAAAAAAAAAAAAAA", "CCCCCCCCCCCCCCCC",
+        "GGGGGGGGGGGGGGGG", "TTTTTTTTTTTTTTTT", "ACACACACACACACAC", "GTGTGTGTGTGTGTGT", "acgtNNNNNNNNacgt",
+        "ACGTACGTACGTACGT", "ACGTACGTACGTACGT", "TGCATGCATGCATGCA", "ACGTACGTACGTACGT", "ACGTACGTACGTACGT",
+    };
+    uint8_t ctbytes[25];
+    const void *cols[25];
+    uint64_t colsize[25];
+    int i = 0;
+    for (i = 0; i < 25; i++)
+    {
+        ctbytes[i] = 1;
+        cols[i] = seq[i];
+        colsize[i] = 16;
+    }
+    int errors = 0;
+    if (write_binsrc1_file("genoref_lowercase.test.bin", 1, 25, ctbytes, cols, colsize) == 0)
+    {
+        (void) fprintf(stderr, "%s Unable to write the test file\n", __func__);
+        return 1;
+    }
+    mmfile_t mf = {0};
+    mmap_genoref_file("genoref_lowercase.test.bin", &mf);
+    errors += check_genoref_packed_file(mf, "genoref_lowercase_packed.test.bin", __func__);
+    (void) munmap_binfile(mf);
+    return errors;
+}
+
+void benchmark_get_genoref_seq_packed()
+{
+    mmfile_t mf = {0};
+    mmap_genoref_file("genoref_lowercase_packed.test.bin", &mf);
+    uint8_t chrom = 0;
+    uint64_t tstart = 0, tend = 0;
+    int i = 0;
+    int size = 100000;
+    tstart = get_time();
+    for (i=0 ; i < size; i++)
+    {
+        for (chrom = 1; chrom <= 25; chrom++)
+        {
+            get_genoref_seq(mf, chrom, 1);
+        }
+    }
+    tend = get_time();
+    (void) fprintf(stdout, " * %s : %lu ns/op\n", __func__, (tend - tstart)/(uint64_t)(size*25));
+    (void) munmap_binfile(mf);
+}
+
 int main()
 {
     int errors = 0;
@@ -445,14 +753,22 @@ int main()
     errors += test_swap_alleles();
     errors += test_get_genoref_seq(genoref);
     errors += test_check_reference(genoref);
+    errors += test_check_reference_seq();
     errors += test_flip_allele();
+    errors += test_complement_allele();
+    errors += test_reverse_complement_allele();
     errors += test_normalize_variant(genoref);
     errors += test_normalized_variantkey(genoref);
+    errors += test_normalize_variant_batch(genoref);
+    errors += test_genoref_packed_file(genoref);
+    errors += test_genoref_packed_file_lowercase();
 
     benchmark_aztoupper();
     benchmark_prepend_char();
     benchmark_get_genoref_seq(genoref);
+    benchmark_check_reference_seq();
     benchmark_flip_allele();
+    benchmark_get_genoref_seq_packed();
 
     err = munmap_binfile(genoref);
     if (err != 0)
@@ -246,6 +246,52 @@ int test_get_variantkey_endpos(nrvk_cols_t nvc)
     return errors;
 }
 
+int test_get_variantkey_endpos_array(nrvk_cols_t nvc)
+{
+    int errors = 0;
+    int i = 0;
+    uint64_t vk[(TEST_DATA_SIZE + 1)];
+    uint32_t endpos[(TEST_DATA_SIZE + 1)];
+    uint32_t exp = 0;
+    // sorted input with a non-reversible VariantKey not in the NRVK file at the end
+    for (i=0 ; i < TEST_DATA_SIZE; i++)
+    {
+        vk[i] = test_data[i].vk;
+    }
+    vk[TEST_DATA_SIZE] = 0xc800c35c96c18497;
+    get_variantkey_endpos_array(nvc, vk, (TEST_DATA_SIZE + 1), endpos);
+    for (i=0 ; i < TEST_DATA_SIZE; i++)
+    {
+        exp = test_data[i].pos + test_data[i].sizeref;
+        if (endpos[i] != exp)
+        {
+            (void) fprintf(stderr, "%s (%d) Expecting END POS %" PRIu32 ", got %" PRIu32 "\n", __func__, i, exp, endpos[i]);
+            ++errors;
+        }
+    }
+    if (endpos[TEST_DATA_SIZE] != test_data[(TEST_DATA_SIZE - 1)].pos)
+    {
+        (void) fprintf(stderr, "%s Expecting END POS %" PRIu32 ", got %" PRIu32 "\n", __func__, test_data[(TEST_DATA_SIZE - 1)].pos, endpos[TEST_DATA_SIZE]);
+        ++errors;
+    }
+    // reverse order
+    for (i=0 ; i < TEST_DATA_SIZE; i++)
+    {
+        vk[i] = test_data[(TEST_DATA_SIZE - 1 - i)].vk;
+    }
+    get_variantkey_endpos_array(nvc, vk, TEST_DATA_SIZE, endpos);
+    for (i=0 ; i < TEST_DATA_SIZE; i++)
+    {
+        exp = test_data[(TEST_DATA_SIZE - 1 - i)].pos + test_data[(TEST_DATA_SIZE - 1 - i)].sizeref;
+        if (endpos[i] != exp)
+        {
+            (void) fprintf(stderr, "%s (%d) Expecting END POS %" PRIu32 ", got %" PRIu32 "\n", __func__, i, exp, endpos[i]);
+            ++errors;
+        }
+    }
+    return errors;
+}
+
 int test_get_variantkey_chrom_startpos()
 {
     int errors = 0;
@@ -305,6 +351,195 @@ int test_nrvk_bin_to_tsv_error(nrvk_cols_t nvc)
     return errors;
 }
 
+int test_get_variantkey_ref_length_cached(nrvk_cols_t nvc)
+{
+    int errors = 0;
+    int i = 0, j = 0;
+    size_t sizeref = 0;
+    static nrvk_cache_t cache;
+    (void) memset(&cache, 0, sizeof(cache));
+    for (j=0 ; j < 2; j++)
+    {
+        for (i=0 ; i < TEST_DATA_SIZE; i++)
+        {
+            sizeref = get_variantkey_ref_length_cached(nvc, &cache, test_data[i].vk);
+            if (sizeref != test_data[i].sizeref)
+            {
+                (void) fprintf(stderr, "%s (%d-%d) Expecting REF size %lu, got %lu\n", __func__, j, i, test_data[i].sizeref, sizeref);
+                ++errors;
+            }
+            if (get_variantkey_endpos_cached(nvc, &cache, test_data[i].vk) != (test_data[i].pos + test_data[i].sizeref))
+            {
+                (void) fprintf(stderr, "%s (%d-%d) Unexpected END POS\n", __func__, j, i);
+                ++errors;
+            }
+        }
+    }
+    sizeref = get_variantkey_ref_length_cached(nvc, &cache, 0xffffffffffffffff);
+    if (sizeref != 0)
+    {
+        (void) fprintf(stderr, "%s Expecting REF size 0, got %lu\n", __func__, sizeref);
+        ++errors;
+    }
+    return errors;
+}
+
+int test_nrvk_reflen_file(nrvk_cols_t nvc)
+{
+    int errors = 0;
+    int i = 0;
+    uint8_t tmp[TEST_DATA_SIZE];
+    size_t sizeref = 0;
+    size_t len = write_nrvk_reflen_file(nvc, "nrvkref.test.bin", tmp);
+    if (len != (32 + 16))
+    {
+        (void) fprintf(stderr, "%s Expecting file with 48 bytes, got %lu\n", __func__, len);
+        return 1;
+    }
+    mmfile_t mf = {0};
+    mmap_nrvk_reflen_file("nrvkref.test.bin", &mf, &nvc);
+    if (nvc.reflen == NULL)
+    {
+        (void) fprintf(stderr, "%s Expecting the REF length column to be mapped\n", __func__);
+        return 1;
+    }
+    uint64_t first = 0;
+    for (i=0 ; i < TEST_DATA_SIZE; i++)
+    {
+        sizeref = get_variantkey_ref_length(nvc, test_data[i].vk);
+        if (sizeref != test_data[i].sizeref)
+        {
+            (void) fprintf(stderr, "%s (%d) Expecting REF size %lu, got %lu\n", __func__, i, test_data[i].sizeref, sizeref);
+            ++errors;
+        }
+        sizeref = find_nrvk_ref_length_from(nvc, &first, test_data[i].vk);
+        if (sizeref != test_data[i].sizeref)
+        {
+            (void) fprintf(stderr, "%s (%d) Expecting REF size %lu, got %lu\n", __func__, i, test_data[i].sizeref, sizeref);
+            ++errors;
+        }
+    }
+    int err = munmap_binfile(mf);
+    if (err != 0)
+    {
+        (void) fprintf(stderr, "%s Got %d error while unmapping the file\n", __func__, err);
+        ++errors;
+    }
+    return errors;
+}
+
+int test_write_nrvk_reflen_file_error(nrvk_cols_t nvc)
+{
+    int errors = 0;
+    uint8_t tmp[TEST_DATA_SIZE];
+    size_t len = write_nrvk_reflen_file(nvc, "/WRONG/../../nrvkref.test.bin", tmp);
+    if (len != 0)
+    {
+        (void) fprintf(stderr, "%s Expecting 0 bytes, got %lu\n", __func__, len);
+        ++errors;
+    }
+    return errors;
+}
+
+void benchmark_get_variantkey_endpos_cached(nrvk_cols_t nvc)
+{
+    static nrvk_cache_t cache;
+    uint64_t tstart = 0, tend = 0;
+    uint64_t sum = 0;
+    int i = 0;
+    int size = 100000;
+    tstart = get_time();
+    for (i=0 ; i < size; i++)
+    {
+        sum += get_variantkey_endpos_cached(nvc, &cache, test_data[(i % TEST_DATA_SIZE)].vk);
+    }
+    tend = get_time();
+    (void) fprintf(stdout, " * %s : %lu ns/op (%" PRIu64 ")\n", __func__, (tend - tstart)/size, sum);
+}
+
+int compare_files(const char *fa, const char *fb)
+{
+    char ba[512], bb[512];
+    size_t na = 0, nb = 0;
+    int diff = 0;
+    FILE *pa = fopen(fa, "re");
+    FILE *pb = fopen(fb, "re");
+    if ((pa == NULL) || (pb == NULL))
+    {
+        diff = 1;
+    }
+    while (diff == 0)
+    {
+        na = fread(ba, 1, sizeof(ba), pa);
+        nb = fread(bb, 1, sizeof(bb), pb);
+        diff = ((na != nb) || (memcmp(ba, bb, na) != 0));
+        if (na == 0)
+        {
+            break;
+        }
+    }
+    if (pa != NULL)
+    {
+        (void) fclose(pa);
+    }
+    if (pb != NULL)
+    {
+        (void) fclose(pb);
+    }
+    return diff;
+}
+
+int test_nrvk2_file(nrvk_cols_t nvc)
+{
+    int errors = 0;
+    uint64_t base[1];
+    uint16_t delta[TEST_DATA_SIZE];
+    uint8_t data[256];
+    uint64_t datasize = get_nrvk2_data_size(nvc);
+    if (datasize != 57)
+    {
+        (void) fprintf(stderr, "%s Expecting 57 data bytes, got %" PRIu64 "\n", __func__, datasize);
+        return 1;
+    }
+    size_t len = write_nrvk2_file(nvc, "nrvk2.test.bin", base, delta, data);
+    if (len != 232)
+    {
+        (void) fprintf(stderr, "%s Expecting file with 232 bytes, got %lu\n", __func__, len);
+        return 1;
+    }
+    mmfile_t mf = {0};
+    nrvk_cols_t nvc2 = {0};
+    mmap_nrvk_file("nrvk2.test.bin", &mf, &nvc2);
+    if ((nvc2.nrows != TEST_DATA_SIZE) || (nvc2.delta == NULL))
+    {
+        (void) fprintf(stderr, "%s Expecting %d items in v2 format, got instead: %" PRIu64 "\n", __func__, TEST_DATA_SIZE, nvc2.nrows);
+        return 1;
+    }
+    errors += test_find_ref_alt_by_variantkey(nvc2);
+    errors += test_reverse_variantkey(nvc2);
+    errors += test_get_variantkey_ref_length(nvc2);
+    errors += test_get_variantkey_endpos_array(nvc2);
+    len = nrvk_bin_to_tsv(nvc2, "nrvk2.test");
+    if ((len != 305) || (compare_files("nrvk.test", "nrvk2.test") != 0))
+    {
+        (void) fprintf(stderr, "%s The v2 TSV output differs from v1\n", __func__);
+        ++errors;
+    }
+    len = write_nrvk2_file(nvc2, "nrvk2.test.bin", base, delta, data);
+    if (len != 0)
+    {
+        (void) fprintf(stderr, "%s Expecting 0 bytes from a v2 source, got %lu\n", __func__, len);
+        ++errors;
+    }
+    int err = munmap_binfile(mf);
+    if (err != 0)
+    {
+        (void) fprintf(stderr, "%s Got %d error while unmapping the file\n", __func__, err);
+        ++errors;
+    }
+    return errors;
+}
+
 int main()
 {
     int errors = 0;
@@ -327,13 +562,19 @@ int main()
     errors += test_get_variantkey_ref_length_reversible(nvc);
     errors += test_get_variantkey_ref_length_notfound(nvc);
     errors += test_get_variantkey_endpos(nvc);
+    errors += test_get_variantkey_endpos_array(nvc);
     errors += test_get_variantkey_chrom_startpos();
     errors += test_get_variantkey_chrom_endpos(nvc);
     errors += test_nrvk_bin_to_tsv(nvc);
     errors += test_nrvk_bin_to_tsv_error(nvc);
+    errors += test_get_variantkey_ref_length_cached(nvc);
+    errors += test_nrvk_reflen_file(nvc);
+    errors += test_write_nrvk_reflen_file_error(nvc);
+    errors += test_nrvk2_file(nvc);
 
     benchmark_find_ref_alt_by_variantkey(nvc);
     benchmark_reverse_variantkey(nvc);
+    benchmark_get_variantkey_endpos_cached(nvc);
 
     err = munmap_binfile(nrvk);
     if (err != 0)
@@ -0,0 +1,305 @@
+// VariantKey
+//
+// test_regionindex.c
+//
+// @category   Test
+// @author     Nicola Asuni <info@tecnick.com>
+// @link       https://github.com/tecnickcom/variantkey
+// @license    MIT [LICENSE](https://raw.githubusercontent.com/tecnickcom/variantkey/main/LICENSE)
+
+// Test for regionindex
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "../src/variantkey/regionindex.h"
+#include "../src/variantkey/regionkey.h"
+#include "../src/variantkey/set.h"
+
+enum
+{
+    TEST_REGIONS_SIZE = 1000,
+    TEST_QUERIES_SIZE = 500,
+    TEST_MAXROWS = TEST_REGIONS_SIZE
+};
+
+static uint64_t test_rk[TEST_REGIONS_SIZE];
+static uint64_t test_maxend[TEST_REGIONS_SIZE];
+static uint64_t test_rows[TEST_MAXROWS];
+static uint64_t test_exp[TEST_MAXROWS];
+
+// returns current time in nanoseconds
+uint64_t get_time()
+{
+    struct timespec t;
+    (void) timespec_get(&t, TIME_UTC);
+    return (((uint64_t)t.tv_sec * 1000000000) + (uint64_t)t.tv_nsec);
+}
+
+// simple deterministic pseudo-random number generator
+uint32_t test_rand(uint64_t *seed)
+{
+    *seed = ((*seed * 6364136223846793005ULL) + 1442695040888963407ULL);
+    return (uint32_t)(*seed >> 33);
+}
+
+// generate sorted regions on 3 chromosomes, including some long nested regions
+void init_test_regions()
+{
+    uint64_t tmp[TEST_REGIONS_SIZE];
+    uint64_t seed = 42;
+    uint32_t startpos = 0, len = 0;
+    int i = 0;
+    for (i = 0; i < TEST_REGIONS_SIZE; i++)
+    {
+        startpos = (test_rand(&seed) % 100000);
+        len = ((i % 50) == 0) ? (test_rand(&seed) % 50000) : (1 + (test_rand(&seed) % 500));
+        test_rk[i] = encode_regionkey((uint8_t)(1 + (test_rand(&seed) % 3)), startpos, (startpos + len), 0);
+    }
+    sort_uint64_t(test_rk, tmp, TEST_REGIONS_SIZE);
+}
+
+uint64_t brute_force_overlaps(uint8_t chrom, uint32_t startpos, uint32_t endpos, uint64_t *rows)
+{
+    uint64_t n = 0;
+    uint64_t i = 0;
+    for (i = 0; i < TEST_REGIONS_SIZE; i++)
+    {
+        if (are_overlapping_region_regionkey(chrom, startpos, endpos, test_rk[i]))
+        {
+            rows[n++] = i;
+        }
+    }
+    return n;
+}
+
+int check_overlaps(rkindex_cols_t rki, const char *func)
+{
+    int errors = 0;
+    uint64_t seed = 7;
+    uint64_t n = 0, e = 0;
+    uint32_t startpos = 0, endpos = 0;
+    uint8_t chrom = 0;
+    int i = 0;
+    for (i = 0; i < TEST_QUERIES_SIZE; i++)
+    {
+        chrom = (uint8_t)(1 + (test_rand(&seed) % 4));
+        startpos = (test_rand(&seed) % 110000);
+        endpos = (startpos + 1 + (test_rand(&seed) % 2000));
+        n = find_region_regionkey_overlaps(rki, chrom, startpos, endpos, test_rows, TEST_MAXROWS);
+        e = brute_force_overlaps(chrom, startpos, endpos, test_exp);
+        if (n != e)
+        {
+            (void) fprintf(stderr, "%s (%d) Expecting %" PRIu64 " overlaps, got %" PRIu64 "\n", func, i, e, n);
+            ++errors;
+            continue;
+        }
+        if (memcmp(test_rows, test_exp, (n * sizeof(uint64_t))) != 0)
+        {
+            (void) fprintf(stderr, "%s (%d) Unexpected overlapping rows\n", func, i);
+            ++errors;
+        }
+    }
+    return errors;
+}
+
+int test_get_regionkey_index_rootk()
+{
+    int errors = 0;
+    static const uint64_t nrows[8] = {0, 1, 2, 3, 4, 7, 8, 1000};
+    static const uint8_t exp[8] = {0, 0, 1, 1, 2, 2, 3, 9};
+    int i = 0;
+    uint8_t res = 0;
+    for (i = 0; i < 8; i++)
+    {
+        res = get_regionkey_index_rootk(nrows[i]);
+        if (res != exp[i])
+        {
+            (void) fprintf(stderr, "%s (%d) Expecting %" PRIu8 ", got %" PRIu8 "\n", __func__, i, exp[i], res);
+            ++errors;
+        }
+    }
+    return errors;
+}
+
+int test_find_region_regionkey_overlaps()
+{
+    rkindex_cols_t rki = {0};
+    rki.rk = test_rk;
+    rki.maxend = test_maxend;
+    rki.nrows = TEST_REGIONS_SIZE;
+    rki.rootk = build_regionkey_index(test_rk, TEST_REGIONS_SIZE, test_maxend);
+    return check_overlaps(rki, __func__);
+}
+
+int test_find_region_regionkey_overlaps_small()
+{
+    int errors = 0;
+    uint64_t rk[5] = {0};
+    uint64_t maxend[5] = {0};
+    uint64_t rows[5] = {0};
+    rkindex_cols_t rki = {0};
+    rki.rk = rk;
+    rki.maxend = maxend;
+    rk[0] = encode_regionkey(1, 10, 1000, 0);
+    rk[1] = encode_regionkey(1, 20, 30, 0);
+    rk[2] = encode_regionkey(1, 40, 50, 0);
+    rk[3] = encode_regionkey(1, 500, 600, 0);
+    rk[4] = encode_regionkey(2, 0, 100, 0);
+    uint64_t n = 0;
+    for (rki.nrows = 0; rki.nrows <= 5; rki.nrows++)
+    {
+        rki.rootk = build_regionkey_index(rk, rki.nrows, maxend);
+        n = find_region_regionkey_overlaps(rki, 1, 45, 510, rows, 5);
+        uint64_t exp = ((rki.nrows > 3) ? 3 : ((rki.nrows > 2) ? 2 : ((rki.nrows > 0) ? 1 : 0)));
+        if (n != exp)
+        {
+            (void) fprintf(stderr, "%s (%" PRIu64 ") Expecting %" PRIu64 " overlaps, got %" PRIu64 "\n", __func__, rki.nrows, exp, n);
+            ++errors;
+        }
+    }
+    rki.nrows = 5;
+    rki.rootk = build_regionkey_index(rk, rki.nrows, maxend);
+    // limited output buffer
+    n = find_region_regionkey_overlaps(rki, 1, 0, 2000, rows, 2);
+    if ((n != 4) || (rows[0] != 0) || (rows[1] != 1))
+    {
+        (void) fprintf(stderr, "%s Expecting 4 overlaps, got %" PRIu64 "\n", __func__, n);
+        ++errors;
+    }
+    n = find_regionkey_overlaps(rki, encode_regionkey(2, 99, 200, 0), rows, 5);
+    if ((n != 1) || (rows[0] != 4))
+    {
+        (void) fprintf(stderr, "%s Expecting 1 overlap, got %" PRIu64 "\n", __func__, n);
+        ++errors;
+    }
+    n = find_regionkey_overlaps(rki, encode_regionkey(3, 0, 200, 0), rows, 5);
+    if (n != 0)
+    {
+        (void) fprintf(stderr, "%s Expecting 0 overlaps, got %" PRIu64 "\n", __func__, n);
+        ++errors;
+    }
+    return errors;
+}
+
+int test_find_variantkey_regionkey_overlaps(nrvk_cols_t nvc)
+{
+    int errors = 0;
+    uint64_t rk[2] = {0};
+    uint64_t maxend[2] = {0};
+    uint64_t rows[2] = {0};
+    rkindex_cols_t rki = {0};
+    rki.rk = rk;
+    rki.maxend = maxend;
+    rki.nrows = 2;
+    rk[0] = encode_regionkey(2, 100003, 100010, 0);
+    rk[1] = encode_regionkey(2, 100012, 100020, 0);
+    rki.rootk = build_regionkey_index(rk, rki.nrows, maxend);
+    // non-reversible VariantKey with REF length 11 at position 100002 (see nrvk.10.bin)
+    uint64_t n = find_variantkey_regionkey_overlaps(rki, nvc, 0x1000c3517f91cdb1, rows, 2);
+    if ((n != 2) || (rows[0] != 0) || (rows[1] != 1))
+    {
+        (void) fprintf(stderr, "%s Expecting 2 overlaps, got %" PRIu64 "\n", __func__, n);
+        ++errors;
+    }
+    // reversible VariantKey with REF length 1 at position 100002
+    n = find_variantkey_regionkey_overlaps(rki, nvc, variantkey("2", 1, 100002, "A", 1, "G", 1), rows, 2);
+    if (n != 0)
+    {
+        (void) fprintf(stderr, "%s Expecting 0 overlaps, got %" PRIu64 "\n", __func__, n);
+        ++errors;
+    }
+    return errors;
+}
+
+int test_rkindex_file()
+{
+    int errors = 0;
+    size_t len = write_regionkey_index_file("rkidx.test.bin", test_rk, test_maxend, TEST_REGIONS_SIZE);
+    size_t exp = (40 + (TEST_REGIONS_SIZE * 16));
+    if (len != exp)
+    {
+        (void) fprintf(stderr, "%s Expecting file with %lu bytes, got %lu\n", __func__, exp, len);
+        return 1;
+    }
+    mmfile_t mf = {0};
+    rkindex_cols_t rki = {0};
+    mmap_rkindex_file("rkidx.test.bin", &mf, &rki);
+    if (rki.nrows != TEST_REGIONS_SIZE)
+    {
+        (void) fprintf(stderr, "%s Expecting %d items, got instead: %" PRIu64 "\n", __func__, TEST_REGIONS_SIZE, rki.nrows);
+        return 1;
+    }
+    errors += check_overlaps(rki, __func__);
+    int err = munmap_binfile(mf);
+    if (err != 0)
+    {
+        (void) fprintf(stderr, "%s Got %d error while unmapping the file\n", __func__, err);
+        ++errors;
+    }
+    return errors;
+}
+
+int test_write_regionkey_index_file_error()
+{
+    int errors = 0;
+    size_t len = write_regionkey_index_file("/WRONG/../../rkidx.test.bin", test_rk, test_maxend, TEST_REGIONS_SIZE);
+    if (len != 0)
+    {
+        (void) fprintf(stderr, "%s Expecting 0 bytes, got %lu\n", __func__, len);
+        ++errors;
+    }
+    return errors;
+}
+
+void benchmark_find_region_regionkey_overlaps()
+{
+    rkindex_cols_t rki = {0};
+    rki.rk = test_rk;
+    rki.maxend = test_maxend;
+    rki.nrows = TEST_REGIONS_SIZE;
+    rki.rootk = get_regionkey_index_rootk(TEST_REGIONS_SIZE);
+    uint64_t tstart = 0, tend = 0;
+    uint64_t sum = 0;
+    int i = 0;
+    int size = 100000;
+    tstart = get_time();
+    for (i = 0; i < size; i++)
+    {
+        sum += find_region_regionkey_overlaps(rki, 2, (uint32_t)(i % 100000), (uint32_t)((i % 100000) + 100), test_rows, TEST_MAXROWS);
+    }
+    tend = get_time();
+    (void) fprintf(stdout, " * %s : %lu ns/op (%" PRIu64 ")\n", __func__, (tend - tstart)/size, sum);
+}
+
+int main()
+{
+    int errors = 0;
+    int err = 0;
+
+    mmfile_t nrvk = {0};
+    nrvk_cols_t nvc = {0};
+    mmap_nrvk_file("nrvk.10.bin", &nrvk, &nvc);
+
+    init_test_regions();
+
+    errors += test_get_regionkey_index_rootk();
+    errors += test_find_region_regionkey_overlaps();
+    errors += test_find_region_regionkey_overlaps_small();
+    errors += test_find_variantkey_regionkey_overlaps(nvc);
+    errors += test_rkindex_file();
+    errors += test_write_regionkey_index_file_error();
+
+    benchmark_find_region_regionkey_overlaps();
+
+    err = munmap_binfile(nrvk);
+    if (err != 0)
+    {
+        (void) fprintf(stderr, "Got %d error while unmapping the nrvk file\n", err);
+        return 1;
+    }
+
+    return errors;
+}
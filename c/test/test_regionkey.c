@@ -19,11 +19,15 @@
 #include "../src/variantkey/variantkey.h"
 #include "../src/variantkey/binsearch.h"
 #include "../src/variantkey/nrvk.h"
+#include "../src/variantkey/set.h"
 
 enum
 {
     TEST_DATA_SIZE = 10,
-    TEST_OVERLAP_SIZE = 12
+    TEST_OVERLAP_SIZE = 12,
+    TEST_JOIN_VK_SIZE = 300,
+    TEST_JOIN_RK_SIZE = 200,
+    TEST_JOIN_MAXPAIRS = 7
 };
 
 typedef struct test_data_t
@@ -512,6 +516,124 @@ int test_are_overlapping_variantkey_regionkey(nrvk_cols_t nvc)
     return errors;
 }
 
+// simple deterministic pseudo-random number generator
+uint32_t test_rand(uint64_t *seed)
+{
+    *seed = ((*seed * 6364136223846793005ULL) + 1442695040888963407ULL);
+    return (uint32_t)(*seed >> 33);
+}
+
+int test_find_chrom_rows(nrvk_cols_t nvc)
+{
+    int errors = 0;
+    int i = 0;
+    uint64_t first = 0, last = 0, n = 0;
+    for (i=0 ; i < TEST_DATA_SIZE; i++)
+    {
+        n = find_chrom_rows(nvc.vk, nvc.nrows, test_data[i].echrom, &first, &last);
+        if ((n != 1) || (first != (uint64_t)i) || (last != (uint64_t)(i + 1)))
+        {
+            (void) fprintf(stderr, "%s (%d) Expecting range %d-%d, got %" PRIu64 "-%" PRIu64 "\n", __func__, i, i, (i + 1), first, last);
+            ++errors;
+        }
+    }
+    n = find_chrom_rows(nvc.vk, nvc.nrows, 6, &first, &last);
+    if ((n != 0) || (first != 0) || (last != 0))
+    {
+        (void) fprintf(stderr, "%s Expecting empty range, got %" PRIu64 "-%" PRIu64 "\n", __func__, first, last);
+        ++errors;
+    }
+    return errors;
+}
+
+int check_join_variantkey_regionkey(nrvk_cols_t nvc, const uint64_t *vk, uint64_t vkfirst, uint64_t vklast, const uint64_t *rk, uint64_t rkfirst, uint64_t rklast, uint8_t *seen)
+{
+    int errors = 0;
+    uint64_t active[TEST_JOIN_RK_SIZE];
+    uint64_t vkrows[TEST_JOIN_MAXPAIRS], rkrows[TEST_JOIN_MAXPAIRS];
+    uint64_t n = 0, i = 0, prev = 0;
+    vkrk_join_t jn;
+    init_variantkey_regionkey_join(&jn, active, vkfirst, vklast, rkfirst, rklast);
+    while ((n = join_variantkey_regionkey(nvc, vk, rk, &jn, vkrows, rkrows, TEST_JOIN_MAXPAIRS)) > 0)
+    {
+        for (i = 0; i < n; i++)
+        {
+            if ((vkrows[i] < prev) || (vkrows[i] < vkfirst) || (vkrows[i] >= vklast) || (rkrows[i] < rkfirst) || (rkrows[i] >= rklast))
+            {
+                (void) fprintf(stderr, "%s Unexpected pair %" PRIu64 "-%" PRIu64 "\n", __func__, vkrows[i], rkrows[i]);
+                ++errors;
+                continue;
+            }
+            prev = vkrows[i];
+            if (!are_overlapping_variantkey_regionkey(nvc, vk[vkrows[i]], rk[rkrows[i]]))
+            {
+                (void) fprintf(stderr, "%s Unexpected non overlapping pair %" PRIu64 "-%" PRIu64 "\n", __func__, vkrows[i], rkrows[i]);
+                ++errors;
+            }
+            seen[((vkrows[i] * TEST_JOIN_RK_SIZE) + rkrows[i])]++;
+        }
+    }
+    if (jn.vkpos != vklast)
+    {
+        (void) fprintf(stderr, "%s Incomplete join\n", __func__);
+        ++errors;
+    }
+    return errors;
+}
+
+int test_join_variantkey_regionkey(nrvk_cols_t nvc)
+{
+    int errors = 0;
+    static const char bases[] = "ACGTACGTAC";
+    static uint64_t vk[TEST_JOIN_VK_SIZE];
+    static uint64_t rk[TEST_JOIN_RK_SIZE];
+    static uint64_t tmp[TEST_JOIN_VK_SIZE];
+    static uint8_t seen[(TEST_JOIN_VK_SIZE * TEST_JOIN_RK_SIZE)];
+    uint64_t seed = 3;
+    uint64_t i = 0, j = 0, vkfirst = 0, vklast = 0, rkfirst = 0, rklast = 0;
+    uint32_t pos = 0;
+    uint8_t chrom = 0, exp = 0;
+    for (i = 0; i < TEST_JOIN_VK_SIZE; i++)
+    {
+        // reversible VariantKeys with REF length from 1 to 10, and non-reversible VariantKeys from the NRVK file
+        vk[i] = ((i % 30) == 0) ? nvc.vk[((i / 30) % nvc.nrows)] : variantkey("1", 1, (100000 + (test_rand(&seed) % 40)), bases, (1 + (test_rand(&seed) % 10)), "A", 1);
+        if ((i % 3) == 0)
+        {
+            vk[i] = encode_variantkey(2, (100000 + (test_rand(&seed) % 40)), extract_variantkey_refalt(vk[i]));
+        }
+    }
+    sort_uint64_t(vk, tmp, TEST_JOIN_VK_SIZE);
+    for (i = 0; i < TEST_JOIN_RK_SIZE; i++)
+    {
+        pos = (99990 + (test_rand(&seed) % 60));
+        rk[i] = encode_regionkey((uint8_t)(1 + (test_rand(&seed) % 3)), pos, (pos + (((i % 20) == 0) ? 50 : (test_rand(&seed) % 5))), 0);
+    }
+    sort_uint64_t(rk, tmp, TEST_JOIN_RK_SIZE);
+    // whole columns
+    errors += check_join_variantkey_regionkey(nvc, vk, 0, TEST_JOIN_VK_SIZE, rk, 0, TEST_JOIN_RK_SIZE, seen);
+    // split by chromosome
+    for (chrom = 1; chrom <= 25; chrom++)
+    {
+        if ((find_chrom_rows(vk, TEST_JOIN_VK_SIZE, chrom, &vkfirst, &vklast) > 0) && (find_chrom_rows(rk, TEST_JOIN_RK_SIZE, chrom, &rkfirst, &rklast) > 0))
+        {
+            errors += check_join_variantkey_regionkey(nvc, vk, vkfirst, vklast, rk, rkfirst, rklast, seen);
+        }
+    }
+    for (i = 0; i < TEST_JOIN_VK_SIZE; i++)
+    {
+        for (j = 0; j < TEST_JOIN_RK_SIZE; j++)
+        {
+            exp = (uint8_t)(2 * are_overlapping_variantkey_regionkey(nvc, vk[i], rk[j]));
+            if (seen[((i * TEST_JOIN_RK_SIZE) + j)] != exp)
+            {
+                (void) fprintf(stderr, "%s (%" PRIu64 "-%" PRIu64 ") Expecting %" PRIu8 " matches, got %" PRIu8 "\n", __func__, i, j, exp, seen[((i * TEST_JOIN_RK_SIZE) + j)]);
+                ++errors;
+            }
+        }
+    }
+    return errors;
+}
+
 int test_variantkey_to_regionkey(nrvk_cols_t nvc)
 {
     int errors = 0;
@@ -529,6 +651,112 @@ int test_variantkey_to_regionkey(nrvk_cols_t nvc)
     return errors;
 }
 
+// mixed reversible, non-reversible and unknown VariantKeys paired with RegionKeys
+uint64_t init_test_array(nrvk_cols_t nvc, uint64_t *vk, uint64_t *rk)
+{
+    uint64_t n = 0, i = 0;
+    for (i = 0; i < TEST_OVERLAP_SIZE; i++)
+    {
+        vk[n] = test_overlap[i].a_vk;
+        rk[n++] = test_overlap[i].b_rk;
+    }
+    for (i = 0; i < nvc.nrows; i++)
+    {
+        vk[n] = nvc.vk[i];
+        rk[n++] = encode_regionkey(extract_variantkey_chrom(nvc.vk[i]), (extract_variantkey_pos(nvc.vk[i]) + (uint32_t)(i % 4)), (extract_variantkey_pos(nvc.vk[i]) + 5), 0);
+    }
+    vk[n] = 0xffffffffffffffff;
+    rk[n++] = 0xfffffffff8000000;
+    return n;
+}
+
+int check_array_results(nrvk_cols_t nvc, const uint64_t *vk, const uint64_t *rk, uint64_t n, const char *func)
+{
+    int errors = 0;
+    uint64_t i = 0;
+    uint8_t res[(TEST_OVERLAP_SIZE + TEST_DATA_SIZE + 1)];
+    uint64_t rkres[(TEST_OVERLAP_SIZE + TEST_DATA_SIZE + 1)];
+    are_overlapping_variantkey_regionkey_array(nvc, vk, rk, n, res);
+    variantkey_to_regionkey_array(nvc, vk, n, rkres);
+    for (i = 0; i < n; i++)
+    {
+        if (res[i] != are_overlapping_variantkey_regionkey(nvc, vk[i], rk[i]))
+        {
+            (void) fprintf(stderr, "%s (%" PRIu64 ") Unexpected overlap result %" PRIu8 "\n", func, i, res[i]);
+            ++errors;
+        }
+        if (rkres[i] != variantkey_to_regionkey(nvc, vk[i]))
+        {
+            (void) fprintf(stderr, "%s (%" PRIu64 ") Unexpected RegionKey %016" PRIx64 "\n", func, i, rkres[i]);
+            ++errors;
+        }
+    }
+    return errors;
+}
+
+int test_variantkey_regionkey_array(nrvk_cols_t nvc)
+{
+    int errors = 0;
+    uint64_t vk[(TEST_OVERLAP_SIZE + TEST_DATA_SIZE + 1)];
+    uint64_t rk[(TEST_OVERLAP_SIZE + TEST_DATA_SIZE + 1)];
+    uint64_t n = init_test_array(nvc, vk, rk);
+    errors += check_array_results(nvc, vk, rk, n, __func__);
+    // unsorted input
+    reverse_uint64_t(vk, n);
+    reverse_uint64_t(rk, n);
+    errors += check_array_results(nvc, vk, rk, n, __func__);
+    return errors;
+}
+
+int test_are_overlapping_region_regionkey_array()
+{
+    int errors = 0;
+    int i = 0, j = 0;
+    uint64_t rk[TEST_OVERLAP_SIZE];
+    uint8_t res[TEST_OVERLAP_SIZE];
+    uint8_t exp = 0;
+    for (j = 0; j < TEST_OVERLAP_SIZE; j++)
+    {
+        rk[j] = test_overlap[j].b_rk;
+    }
+    for (i = 0; i < TEST_OVERLAP_SIZE; i++)
+    {
+        are_overlapping_region_regionkey_array(test_overlap[i].a_chrom, test_overlap[i].a_startpos, test_overlap[i].a_endpos, rk, TEST_OVERLAP_SIZE, res);
+        for (j = 0; j < TEST_OVERLAP_SIZE; j++)
+        {
+            exp = are_overlapping_region_regionkey(test_overlap[i].a_chrom, test_overlap[i].a_startpos, test_overlap[i].a_endpos, rk[j]);
+            if (res[j] != exp)
+            {
+                (void) fprintf(stderr, "%s (%d-%d) Expecting %" PRIu8 ", got %" PRIu8 "\n", __func__, i, j, exp, res[j]);
+                ++errors;
+            }
+        }
+    }
+    return errors;
+}
+
+void benchmark_variantkey_to_regionkey_array(nrvk_cols_t nvc)
+{
+    static uint64_t vk[TEST_JOIN_VK_SIZE];
+    static uint64_t rk[TEST_JOIN_VK_SIZE];
+    uint64_t tstart = 0, tend = 0;
+    uint64_t sum = 0;
+    int i = 0;
+    int size = 10000;
+    for (i = 0; i < TEST_JOIN_VK_SIZE; i++)
+    {
+        vk[i] = ((i % 30) == 0) ? nvc.vk[((i / 30) % nvc.nrows)] : encode_variantkey((uint8_t)(1 + (i % 25)), (uint32_t)(100000 + i), ((uint32_t)(1 + (i % 10)) << 27));
+    }
+    tstart = get_time();
+    for (i = 0; i < size; i++)
+    {
+        variantkey_to_regionkey_array(nvc, vk, TEST_JOIN_VK_SIZE, rk);
+        sum += rk[(i % TEST_JOIN_VK_SIZE)];
+    }
+    tend = get_time();
+    (void) fprintf(stdout, " * %s : %lu ns/op (%" PRIx64 ")\n", __func__, (tend - tstart)/(size * TEST_JOIN_VK_SIZE), sum);
+}
+
 int main()
 {
     int errors = 0;
@@ -564,10 +792,15 @@ int main()
     errors += test_are_overlapping_regionkeys();
     errors += test_are_overlapping_variantkey_regionkey(nvc);
     errors += test_variantkey_to_regionkey(nvc);
+    errors += test_find_chrom_rows(nvc);
+    errors += test_join_variantkey_regionkey(nvc);
+    errors += test_variantkey_regionkey_array(nvc);
+    errors += test_are_overlapping_region_regionkey_array();
 
     benchmark_decode_regionkey();
     benchmark_reverse_regionkey();
     benchmark_regionkey();
+    benchmark_variantkey_to_regionkey_array(nvc);
 
     err = munmap_binfile(nrvk);
     if (err != 0)
@@ -495,9 +495,11 @@ func (crv RSIDVARCols) FindVRChromPosRange(first, last uint64, chrom uint8, posM
 // NRVKCols contains the NRVK memory mapped file column info.
 type NRVKCols struct {
 	Vk     unsafe.Pointer // Pointer to the VariantKey column.
-	Offset unsafe.Pointer // Pointer to the Offset column.
+	Offset unsafe.Pointer // Pointer to the Offset column (block base offsets for the v2 format).
 	Data   unsafe.Pointer // Pointer to the Data column.
 	NRows  uint64         // Number of rows.
+	RefLen unsafe.Pointer // Pointer to the optional REF length column.
+	Delta  unsafe.Pointer // Pointer to the v2 delta offset column.
 }
 
 // castCNRVKColsToGo convert C.nrvk_cols_t to GO NRVKCols.
@@ -507,6 +509,8 @@ func castCNRVKColsToGo(nr C.nrvk_cols_t) NRVKCols {
 		Offset: unsafe.Pointer(nr.offset), // #nosec
 		Data:   unsafe.Pointer(nr.data),   // #nosec
 		NRows:  uint64(nr.nrows),
+		RefLen: unsafe.Pointer(nr.reflen), // #nosec
+		Delta:  unsafe.Pointer(nr.delta),  // #nosec
 	}
 }
 
@@ -518,6 +522,8 @@ func castGoNRVKColsToC(nr NRVKCols) C.nrvk_cols_t {
 	cnr.offset = (*C.uint64_t)(nr.Offset)
 	cnr.data = (*C.uint8_t)(nr.Data)
 	cnr.nrows = C.uint64_t(nr.NRows)
+	cnr.reflen = (*C.uint8_t)(nr.RefLen)
+	cnr.delta = (*C.uint16_t)(nr.Delta)
 
 	return cnr
 }
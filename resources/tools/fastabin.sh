@@ -4,6 +4,7 @@
 #
 # Create a binary version of the input reference genome sequence FASTA file for quick lookup.
 # It only extract the first 25 sequences for chromosomes 1 to 22, X, Y and MT.
+# NOTE: the faster c/fastabin tool maps the sequences to the chromosomes by name.
 #
 # Nicola Asuni
 # ------------------------------------------------------------------------------